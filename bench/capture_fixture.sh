@@ -0,0 +1,90 @@
+#!/bin/sh
+# Снимает дерево /proc и /sys, которое читают провайдеры, и выводы внешних утилит
+# в каталог для sysinfo_bench --root DIR. Пример: ./bench/capture_fixture.sh fixtures/myhost
+set -eu
+
+dest=${1:?usage: capture_fixture.sh DIR}
+mkdir -p "$dest"
+
+# Файлы sysfs и procfs сообщают размер 4096 или 0, поэтому копируем через cat
+copy() {
+    [ -r "$1" ] || return 0
+    mkdir -p "$dest$(dirname "$1")"
+    cat "$1" > "$dest$1" 2>/dev/null || rm -f "$dest$1"
+}
+
+# Все читаемые файлы каталога до заданной глубины; символические ссылки разворачиваются
+copy_tree() {
+    [ -d "$1" ] || return 0
+    find -L "$1" -maxdepth "$2" -type f -readable 2>/dev/null | while read -r file; do copy "$file"; done
+}
+
+for file in stat meminfo vmstat diskstats cpuinfo self/mountinfo pressure/cpu pressure/memory pressure/io; do copy "/proc/$file"; done
+for dir in /proc/[0-9]*; do
+    copy "$dir/stat"
+    copy "$dir/cmdline"
+done
+
+copy_tree /sys/devices/system/cpu 4
+copy_tree /sys/devices/system/node 2
+copy_tree /sys/class/thermal 2
+copy_tree /sys/class/hwmon 2
+copy_tree /sys/class/rfkill 2
+for dev in /sys/block/*; do
+    copy "$dev/dev"
+    copy "$dev/size"
+    copy "$dev/device/model"
+    copy "$dev/dm/name"
+    for part in "$dev"/*/partition; do
+        [ -e "$part" ] || continue
+        copy "$part"
+        copy "$(dirname "$part")/dev"
+    done
+done
+# Видеоадаптеры: каталог устройства PCI с файлами amdgpu и hwmon, файлы i915 в /sys/class/drm
+for dev in /sys/bus/pci/devices/*; do
+    case $(cat "$dev/class" 2>/dev/null) in 0x03*) ;; *) continue ;; esac
+    for file in class vendor device uevent gpu_busy_percent mem_info_vram_used mem_info_vram_total pp_dpm_sclk pp_dpm_mclk; do
+        copy "$dev/$file"
+    done
+    for hwmon in "$dev"/hwmon/hwmon*; do
+        copy "$hwmon/temp1_input"
+        copy "$hwmon/power1_average"
+        copy "$hwmon/power1_input"
+    done
+    for card in "$dev"/drm/card*; do
+        [ -e "$card" ] || continue
+        mkdir -p "$dest$card"
+        name=$(basename "$card")
+        copy "/sys/class/drm/$name/gt_cur_freq_mhz"
+        copy "/sys/class/drm/$name/gt_max_freq_mhz"
+        copy "/sys/class/drm/$name/power/rc6_residency_ms"
+    done
+done
+[ -d /sys/class/bluetooth ] && mkdir -p "$dest/sys/class/bluetooth" && ls /sys/class/bluetooth | while read -r hci; do
+    mkdir -p "$dest/sys/class/bluetooth/$hci"
+done
+
+# Внешние утилиты заменяются скриптами, которые печатают записанный вывод
+mkdir -p "$dest/bin" "$dest/canned"
+canned() {
+    name=$1
+    shift
+    command -v "$1" > /dev/null 2>&1 || return 0
+    "$@" > "$dest/canned/$name.txt" 2>/dev/null || true
+}
+canned dmidecode-baseboard dmidecode -t baseboard
+canned dmidecode-memory dmidecode -t memory
+canned nvidia-smi nvidia-smi --query-gpu=index,pci.bus_id,name,driver_version,memory.total,memory.used,utilization.gpu,temperature.gpu,clocks.sm,power.draw --format=csv,noheader,nounits
+
+tool() {
+    [ -e "$dest/canned/$2.txt" ] || return 0
+    printf '#!/bin/sh\n%s\n' "$3" > "$dest/bin/$1"
+    chmod +x "$dest/bin/$1"
+}
+canned_dir='$(dirname "$0")/../canned'
+tool dmidecode dmidecode-baseboard "case \"\$*\" in *memory*) cat \"$canned_dir/dmidecode-memory.txt\" ;; *) cat \"$canned_dir/dmidecode-baseboard.txt\" ;; esac"
+# nvidia-smi --loop-ms работает постоянно, поэтому и заменитель повторяет вывод раз в секунду
+tool nvidia-smi nvidia-smi "while cat \"$canned_dir/nvidia-smi.txt\"; do sleep 1; done"
+
+echo "Captured into $dest; run: sysinfo_bench --root $dest"
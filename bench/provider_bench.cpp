@@ -0,0 +1,218 @@
+// Бенчмарк провайдеров: задержка опроса (p50/p90/p99), выделения памяти и запуски процессов
+// на живой системе или на снятом дереве /proc и /sys (см. capture_fixture.sh)
+#include "sysinfo.h"
+
+#include <new>
+
+// Счётчик выделений: замена глобального operator new действует только в этом бинарнике
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct BenchOptions {
+    std::string root;
+    int iterations = 200;
+    int reader_iterations = 0;
+    bool cold = false;    // сбрасывать кэши перед каждым опросом
+    std::string only;     // имя одного раздела
+};
+
+void print_usage(const char* program) {
+    printf("Usage: %s [options]\n"
+           "  --root DIR        read /proc and /sys from DIR; DIR/bin is prepended to PATH for canned tools\n"
+           "  --iterations N    samples per provider (default 200)\n"
+           "  --cold            invalidate caches before every sample\n"
+           "  --only NAME       benchmark a single section, e.g. 'Disks'\n"
+           "  --readers N       compare /proc readers with the iostream path over N iterations\n",
+           program);
+}
+
+bool parse_options(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--root" && i + 1 < argc) {
+            options.root = argv[++i];
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            options.iterations = atoi(argv[++i]);
+            if (options.iterations <= 0) return false;
+        } else if (arg == "--readers" && i + 1 < argc) {
+            options.reader_iterations = atoi(argv[++i]);
+            if (options.reader_iterations <= 0) return false;
+        } else if (arg == "--cold") {
+            options.cold = true;
+        } else if (arg == "--only" && i + 1 < argc) {
+            options.only = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Прежний путь чтения на iostream, как до перехода на ProcFile; нужен только для сравнения
+uint64_t legacy_stat(const std::string& path) {
+    std::ifstream stat_file(path);
+    std::string line, cpu;
+    uint64_t sum = 0;
+    while (std::getline(stat_file, line) && line.compare(0, 3, "cpu") == 0) {
+        std::istringstream iss(line);
+        long user, nice, system, idle, iowait, irq, softirq, steal;
+        iss >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+        sum += user + nice + system + idle + iowait + irq + softirq + steal;
+    }
+    return sum;
+}
+
+uint64_t legacy_meminfo(const std::string& path) {
+    std::ifstream meminfo(path);
+    std::string mem_line;
+    long mem_total = 0, mem_free = 0, mem_available = 0;
+    while (std::getline(meminfo, mem_line)) {
+        if (mem_line.find("MemTotal:") != std::string::npos) {
+            sscanf(mem_line.c_str(), "MemTotal: %ld kB", &mem_total);
+        } else if (mem_line.find("MemFree:") != std::string::npos) {
+            sscanf(mem_line.c_str(), "MemFree: %ld kB", &mem_free);
+        } else if (mem_line.find("MemAvailable:") != std::string::npos) {
+            sscanf(mem_line.c_str(), "MemAvailable: %ld kB", &mem_available);
+        }
+    }
+    return mem_total + mem_free + mem_available;
+}
+
+uint64_t legacy_diskstats(const std::string& path) {
+    std::ifstream diskstats(path);
+    std::string line, name;
+    uint64_t sum = 0;
+    while (std::getline(diskstats, line)) {
+        std::istringstream iss(line);
+        uint64_t major, minor, value;
+        iss >> major >> minor >> name;
+        for (int i = 0; i < 11 && iss >> value; ++i) sum += value;
+    }
+    return sum;
+}
+
+uint64_t reader_diskstats(ProcFile<64 * 1024>& file) {
+    std::string_view text = file.read(), line;
+    uint64_t sum = 0;
+    while (next_line(text, line)) {
+        const char* p = line.data();
+        const char* end = p + line.size();
+        uint64_t major, minor, value;
+        parse_u64(p, end, major);
+        parse_u64(p, end, minor);
+        while (p < end && *p == ' ') ++p;
+        while (p < end && *p != ' ') ++p;
+        for (int i = 0; i < 11 && parse_u64(p, end, value); ++i) sum += value;
+    }
+    return sum;
+}
+
+volatile uint64_t sink; // не даёт компилятору выбросить измеряемый код
+
+// Среднее время одного вызова в наносекундах
+template <typename Body>
+double measure(int iterations, Body&& body) {
+    for (int i = 0; i < iterations / 10 + 1; ++i) sink = body(); // прогрев кэшей и page cache
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) sink = body();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+void run_readers(const BenchOptions& options) {
+    const std::string stat_path = options.root + "/proc/stat";
+    const std::string meminfo_path = options.root + "/proc/meminfo";
+    const std::string diskstats_path = options.root + "/proc/diskstats";
+    const int n = options.reader_iterations;
+    CpuLoadEngine engine;
+    MeminfoReader meminfo(options.root);
+    ProcFile<64 * 1024> diskstats;
+    diskstats.open(diskstats_path);
+
+    struct Case {
+        const char* file;
+        double legacy;
+        double reader;
+    } cases[] = {
+        {"/proc/stat", measure(n, [&] { return legacy_stat(stat_path); }),
+         measure(n, [&] { return uint64_t(engine.update(stat_path)); })},
+        {"/proc/meminfo", measure(n, [&] { return legacy_meminfo(meminfo_path); }),
+         measure(n, [&] { return uint64_t(meminfo.update()); })},
+        {"/proc/diskstats", measure(n, [&] { return legacy_diskstats(diskstats_path); }),
+         measure(n, [&] { return reader_diskstats(diskstats); })},
+    };
+    printf("%-18s %14s %14s %9s\n", "file", "iostream ns", "reader ns", "speedup");
+    for (const Case& c : cases) {
+        printf("%-18s %14.0f %14.0f %8.1fx\n", c.file, c.legacy, c.reader, c.legacy / c.reader);
+    }
+}
+
+void run_providers(const BenchOptions& options) {
+    std::vector<std::unique_ptr<InfoProvider>> providers;
+    std::vector<std::string> names;
+    make_providers(providers, names, {}, options.root);
+
+    printf("%-14s %10s %10s %10s %10s %10s %8s %8s\n", "provider", "p50 us", "p90 us", "p99 us", "max us",
+           "allocs", "forks", "fields");
+    Snapshot snapshot;
+    std::vector<double> latencies;
+    for (size_t i = 0; i < providers.size(); ++i) {
+        if (!options.only.empty() && names[i] != options.only) continue;
+        InfoProvider& provider = *providers[i];
+        // Первый опрос открывает файлы и обнаруживает устройства, в замеры он не входит
+        snapshot.clear();
+        provider.sample(snapshot);
+
+        latencies.clear();
+        uint64_t allocs = 0, forks = 0;
+        for (int iteration = 0; iteration < options.iterations; ++iteration) {
+            if (options.cold) provider.invalidate();
+            snapshot.clear();
+            uint64_t allocs_before = allocations.load(std::memory_order_relaxed);
+            uint64_t forks_before = CommandRunner::spawned.load(std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+            provider.sample(snapshot);
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            allocs += allocations.load(std::memory_order_relaxed) - allocs_before;
+            forks += CommandRunner::spawned.load(std::memory_order_relaxed) - forks_before;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](int p) { return latencies[std::min(latencies.size() - 1, latencies.size() * p / 100)]; };
+        printf("%-14s %10.1f %10.1f %10.1f %10.1f %10.1f %8.2f %8zu\n", names[i].c_str(), percentile(50),
+               percentile(90), percentile(99), latencies.back(), double(allocs) / options.iterations,
+               double(forks) / options.iterations, snapshot.items().size());
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    // Записанные выводы dmidecode, nvidia-smi и других утилит лежат в DIR/bin
+    std::error_code ec;
+    if (!options.root.empty() && std::filesystem::is_directory(options.root + "/bin", ec)) {
+        const char* path = getenv("PATH");
+        setenv("PATH", (options.root + "/bin:" + (path ? path : "/usr/bin:/bin")).c_str(), 1);
+    }
+    // Отдельный кэш конфигурации, чтобы не смешивать данные снимка с данными машины
+    char cache_dir[] = "/tmp/sysinfo-bench-XXXXXX";
+    if (!mkdtemp(cache_dir)) {
+        fprintf(stderr, "Error: cannot create a temporary cache directory: %s\n", strerror(errno));
+        return 1;
+    }
+    setenv("XDG_CACHE_HOME", cache_dir, 1);
+
+    if (options.reader_iterations > 0) run_readers(options);
+    else run_providers(options);
+    std::filesystem::remove_all(cache_dir, ec);
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Запуск внешних команд: разовые с таймаутом и долгоживущие с построчным выводом
+#include "sysinfo.h"
+
+bool spawn_command(const char* cmd, pid_t& pid, int& out_fd) {
+    int pipefd[2];
+    if (pipe2(pipefd, O_CLOEXEC) != 0) return false;
+    // Неблокирующим делаем только конец для чтения: команда пишет как обычно
+    fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL) | O_NONBLOCK);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDERR_FILENO);
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    // Отдельная группа процессов, чтобы по таймауту убить и потомков команды
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    char* const argv[] = {const_cast<char*>("sh"), const_cast<char*>("-c"), const_cast<char*>(cmd), nullptr};
+    int err = posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(pipefd[1]);
+    if (err != 0) {
+        close(pipefd[0]);
+        pid = -1;
+        return false;
+    }
+    out_fd = pipefd[0];
+    return true;
+}
+
+CommandRunner::~CommandRunner() {
+    for (Child& child : children) {
+        if (!child.done) kill_child(child);
+    }
+}
+
+size_t CommandRunner::start(const char* cmd, int timeout_ms) {
+    children.emplace_back();
+    Child& child = children.back();
+    child.started = std::chrono::steady_clock::now();
+    child.deadline = child.started + std::chrono::milliseconds(timeout_ms);
+    child.stats = &SelfStats::instance().command(utility_name(cmd));
+
+    spawned.fetch_add(1, std::memory_order_relaxed);
+    ++SelfStats::thread_commands;
+    if (!spawn_command(cmd, child.pid, child.out_fd)) {
+        child.result.failed = true;
+        child.done = true;
+        child.stats->failures.fetch_add(1, std::memory_order_relaxed);
+        return children.size() - 1;
+    }
+#ifdef SYS_pidfd_open
+    child.pid_fd = static_cast<int>(syscall(SYS_pidfd_open, child.pid, 0));
+#endif
+    return children.size() - 1;
+}
+
+void CommandRunner::wait_all() {
+    std::vector<pollfd> fds;
+    std::vector<size_t> owners;
+    while (true) {
+        fds.clear();
+        owners.clear();
+        auto now = std::chrono::steady_clock::now();
+        auto next_deadline = std::chrono::steady_clock::time_point::max();
+        bool needs_reap_poll = false;
+        for (size_t i = 0; i < children.size(); ++i) {
+            Child& child = children[i];
+            if (child.done) continue;
+            if (now >= child.deadline) {
+                drain(child);
+                kill_child(child);
+                child.result.timed_out = true;
+                child.stats->timeouts.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            next_deadline = std::min(next_deadline, child.deadline);
+            if (child.out_fd >= 0) {
+                fds.push_back({child.out_fd, POLLIN, 0});
+                owners.push_back(i);
+            }
+            if (child.pid_fd >= 0) {
+                fds.push_back({child.pid_fd, POLLIN, 0});
+                owners.push_back(i);
+            } else {
+                // Без pidfd выход команды виден только периодическому waitpid: канал может держать её фоновый потомок
+                needs_reap_poll = true;
+            }
+        }
+        if (next_deadline == std::chrono::steady_clock::time_point::max()) break;
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_deadline - now).count() + 1;
+        if (needs_reap_poll) wait = std::min<long long>(wait, 10);
+        int ready = poll(fds.data(), fds.size(), static_cast<int>(wait));
+        if (ready < 0 && errno != EINTR) break;
+
+        for (size_t k = 0; ready > 0 && k < fds.size(); ++k) {
+            if (fds[k].revents == 0) continue;
+            Child& child = children[owners[k]];
+            if (child.done) continue;
+            if (fds[k].fd == child.out_fd) {
+                drain(child);
+            } else if (fds[k].fd == child.pid_fd) {
+                reap(child, 0);
+            }
+        }
+        for (Child& child : children) {
+            if (!child.done && child.pid_fd < 0) reap(child, WNOHANG);
+        }
+    }
+}
+
+void CommandRunner::drain(Child& child) {
+    if (child.out_fd < 0) return;
+    std::string& out = child.result.output;
+    while (true) {
+        size_t used = out.size();
+        ssize_t count;
+        if (used < kMaxOutput) {
+            size_t chunk = std::min(std::max<size_t>(4096, used), kMaxOutput - used);
+            out.resize(used + chunk);
+            count = read(child.out_fd, &out[used], chunk);
+            out.resize(used + std::max<ssize_t>(count, 0));
+        } else {
+            // Сверх предела дочитываем в пустоту, иначе команда встанет на заполненном канале
+            char discard[4096];
+            count = read(child.out_fd, discard, sizeof(discard));
+            if (count > 0) child.result.truncated = true;
+        }
+        if (count > 0) continue;
+        if (count < 0 && errno == EINTR) continue;
+        if (count == 0 || (count < 0 && errno != EAGAIN)) {
+            close(child.out_fd);
+            child.out_fd = -1;
+        }
+        break;
+    }
+}
+
+void CommandRunner::reap(Child& child, int flags) {
+    int status;
+    pid_t ret = waitpid(child.pid, &status, flags);
+    if (ret != child.pid) return;
+    if (WIFEXITED(status)) child.result.exit_status = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status)) child.result.exit_status = 128 + WTERMSIG(status);
+    // Фоновые потомки могут держать канал открытым, поэтому не ждём EOF
+    drain(child);
+    finish(child);
+}
+
+void CommandRunner::kill_child(Child& child) {
+    if (child.pid > 0) {
+        kill(-child.pid, SIGKILL);
+        int status;
+        waitpid(child.pid, &status, 0);
+    }
+    finish(child);
+}
+
+void CommandRunner::finish(Child& child) {
+    if (child.out_fd >= 0) close(child.out_fd);
+    if (child.pid_fd >= 0) close(child.pid_fd);
+    child.out_fd = -1;
+    child.pid_fd = -1;
+    child.done = true;
+    auto elapsed = std::chrono::steady_clock::now() - child.started;
+    child.stats->latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    child.stats->output_bytes.fetch_add(child.result.output.size(), std::memory_order_relaxed);
+    SelfStats::thread_bytes_read += child.result.output.size();
+}
+
+bool CommandStream::start(const char* cmd) {
+    stop();
+    stats = &SelfStats::instance().command(utility_name(cmd));
+    started = std::chrono::steady_clock::now();
+    CommandRunner::spawned.fetch_add(1, std::memory_order_relaxed);
+    ++SelfStats::thread_commands;
+    if (!spawn_command(cmd, pid, out_fd)) {
+        stats->failures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void CommandStream::stop() {
+    if (out_fd >= 0) close(out_fd);
+    out_fd = -1;
+    pending.clear();
+    if (pid <= 0) return;
+    kill(-pid, SIGKILL);
+    int status;
+    waitpid(pid, &status, 0);
+    pid = -1;
+    // Время жизни процесса: для потока это не задержка, а длительность сеанса
+    stats->latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+}
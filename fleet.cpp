@@ -0,0 +1,615 @@
+// Агент и агрегатор для наблюдения за несколькими машинами
+#include "sysinfo.h"
+
+FleetPublisher::~FleetPublisher() {
+    for (Peer& peer : peers) close(peer.fd);
+}
+
+void FleetPublisher::add_peer(int fd) {
+    if (peers.size() >= kMaxPeers) {
+        close(fd);
+        return;
+    }
+    Peer& peer = peers.emplace_back();
+    peer.fd = fd;
+    peer.subscribed.assign(sections.size(), false);
+    size_t start = fleet_format::begin_frame(peer.out, 'H');
+    put_varint(peer.out, fleet_format::kVersion);
+    put_string(peer.out, host);
+    put_varint(peer.out, sections.size());
+    for (const std::string& name : sections) put_string(peer.out, name);
+    fleet_format::end_frame(peer.out, start);
+    flush(peer);
+}
+
+void FleetPublisher::publish(size_t section, const Snapshot& snapshot) {
+    bool encoded = false;
+    for (Peer& peer : peers) {
+        if (!peer.subscribed[section]) continue;
+        if (!encoded) encode(section, snapshot);
+        encoded = true;
+        send_sample(peer, snapshot);
+    }
+}
+
+void FleetPublisher::add_pollfds(std::vector<pollfd>& fds) const {
+    for (const Peer& peer : peers) {
+        fds.push_back({peer.fd, static_cast<short>(peer.sent < peer.out.size() ? POLLIN | POLLOUT : POLLIN), 0});
+    }
+}
+
+void FleetPublisher::service(const pollfd* fds, const std::vector<const Snapshot*>& latest, std::vector<KeyRequest>& keys) {
+    size_t count = peers.size();
+    for (size_t i = 0, k = 0; k < count; ++k) {
+        Peer& peer = peers[i];
+        bool keep = true;
+        if (fds[k].revents & (POLLIN | POLLERR | POLLHUP)) keep = receive(peer, latest, keys);
+        if (keep && (fds[k].revents & POLLOUT)) keep = flush(peer);
+        if (keep) {
+            ++i;
+        } else {
+            close(peer.fd);
+            peers.erase(peers.begin() + i);
+        }
+    }
+}
+
+void FleetPublisher::encode(size_t section, const Snapshot& snapshot) {
+    frame.clear();
+    size_t start = fleet_format::begin_frame(frame, 'S');
+    put_varint(frame, section);
+    fleet_format::put_fields(frame, snapshot);
+    fleet_format::end_frame(frame, start);
+}
+
+void FleetPublisher::send_sample(Peer& peer, const Snapshot& snapshot) {
+    if (peer.out.size() - peer.sent > kMaxBacklog) return;
+    MetricNames& names = MetricNames::instance();
+    size_t start = std::string::npos;
+    uint32_t fresh = 0;
+    for (const Field& field : snapshot.items()) {
+        if (field.name == 0) continue;
+        if (field.name >= peer.names_sent.size()) peer.names_sent.resize(field.name + 1, false);
+        if (peer.names_sent[field.name]) continue;
+        peer.names_sent[field.name] = true;
+        if (start == std::string::npos) {
+            start = fleet_format::begin_frame(peer.out, 'N');
+            put_raw<uint32_t>(peer.out, 0); // число имён, заполняется ниже
+        }
+        put_varint(peer.out, field.name);
+        put_string(peer.out, names.name(field.name));
+        ++fresh;
+    }
+    if (start != std::string::npos) {
+        memcpy(&peer.out[start + fleet_format::kHeader], &fresh, sizeof(fresh));
+        fleet_format::end_frame(peer.out, start);
+    }
+    peer.out += frame;
+    flush(peer);
+}
+
+bool FleetPublisher::flush(Peer& peer) {
+    while (peer.sent < peer.out.size()) {
+        ssize_t count = send(peer.fd, peer.out.data() + peer.sent, peer.out.size() - peer.sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (count < 0) return errno == EAGAIN || errno == EINTR;
+        peer.sent += count;
+    }
+    peer.out.clear();
+    peer.sent = 0;
+    return true;
+}
+
+bool FleetPublisher::receive(Peer& peer, const std::vector<const Snapshot*>& latest, std::vector<KeyRequest>& keys) {
+    char buf[4096];
+    ssize_t count = read(peer.fd, buf, sizeof(buf));
+    if (count == 0 || (count < 0 && errno != EAGAIN && errno != EINTR)) return false;
+    if (count > 0) peer.in.append(buf, count);
+
+    std::string_view in = peer.in;
+    char type;
+    std::string_view payload;
+    fleet_format::FrameStatus status;
+    while ((status = fleet_format::next_frame(in, type, payload)) == fleet_format::FrameStatus::Ready) {
+        if (type == 'W') {
+            std::vector<bool> wanted(sections.size(), false);
+            uint64_t names;
+            if (!get_varint(payload, names)) return false;
+            for (uint64_t i = 0; i < names; ++i) {
+                std::string_view name;
+                if (!get_string(payload, name)) return false;
+                for (size_t s = 0; s < sections.size(); ++s) {
+                    if (name == "*" || name == sections[s]) wanted[s] = true;
+                }
+            }
+            // Новый подписчик раздела сразу получает последний снимок, не дожидаясь опроса
+            for (size_t s = 0; s < sections.size(); ++s) {
+                bool added = wanted[s] && !peer.subscribed[s];
+                peer.subscribed[s] = wanted[s];
+                if (added && latest[s]) {
+                    encode(s, *latest[s]);
+                    send_sample(peer, *latest[s]);
+                }
+            }
+        } else if (type == 'K') {
+            uint64_t section, key;
+            if (!get_varint(payload, section) || !get_varint(payload, key) || section >= sections.size()) return false;
+            keys.push_back({section, static_cast<int>(key)});
+        }
+    }
+    if (status == fleet_format::FrameStatus::Corrupt) return false;
+    peer.in.erase(0, peer.in.size() - in.size());
+    return true;
+}
+
+AddressResolver::AddressResolver() : state(std::make_shared<State>()) {
+    std::thread(&AddressResolver::loop, state).detach();
+}
+
+AddressResolver::~AddressResolver() {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->stopping = true;
+    }
+    state->wake.notify_one();
+}
+
+void AddressResolver::request(size_t id, const std::string& address) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->queue.emplace_back(id, address);
+    }
+    state->wake.notify_one();
+}
+
+void AddressResolver::collect(std::vector<Result>& out) {
+    uint64_t counter;
+    if (read(state->event_fd, &counter, sizeof(counter)) < 0) {} // только сброс счётчика eventfd
+    std::lock_guard<std::mutex> lock(state->mutex);
+    out.insert(out.end(), state->done.begin(), state->done.end());
+    state->done.clear();
+}
+
+void AddressResolver::loop(std::shared_ptr<State> state) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true) {
+        state->wake.wait(lock, [&] { return state->stopping || !state->queue.empty(); });
+        if (state->stopping) return;
+        auto [id, address] = std::move(state->queue.front());
+        state->queue.pop_front();
+        lock.unlock();
+        Result result{id, false, {}, 0};
+        result.ok = parse_socket_address(address, result.storage, result.length);
+        lock.lock();
+        state->done.push_back(result);
+        uint64_t one = 1;
+        if (write(state->event_fd, &one, sizeof(one)) < 0) {} // переполнение счётчика невозможно
+    }
+}
+
+FleetAggregator::FleetAggregator(const std::vector<std::string>& addresses) : hosts(addresses.size()), epoll_fd(epoll_create1(EPOLL_CLOEXEC)), rate_time(Clock::now()) {
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        hosts[i].address = hosts[i].name = addresses[i];
+        order.push_back(i);
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kResolverTag;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, resolver.fd(), &event);
+}
+
+FleetAggregator::~FleetAggregator() {
+    for (Host& host : hosts) {
+        if (host.fd >= 0) close(host.fd);
+    }
+    if (epoll_fd >= 0) close(epoll_fd);
+}
+
+void FleetAggregator::watch_input(int fd) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kInputTag;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void FleetAggregator::pump(int timeout_ms) {
+    auto now = Clock::now();
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        Host& host = hosts[i];
+        if (host.state == Host::Waiting && now >= host.retry && !host.resolving) {
+            if (host.resolved) {
+                connect_host(i);
+            } else {
+                host.resolving = true;
+                resolver.request(i, host.address);
+            }
+        }
+        else if (host.state == Host::Connecting && now - host.last_frame > kConnectTimeout) drop(i, "connection timed out");
+        else if (host.state == Host::Connected && now - host.last_frame > kStaleAfter) drop(i, "no data from the agent");
+        if (host.state == Host::Waiting && !host.resolving) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(host.retry - now).count();
+            timeout_ms = static_cast<int>(std::clamp<long long>(wait, 0, timeout_ms));
+        }
+    }
+
+    events.resize(std::clamp<size_t>(hosts.size() + 1, 16, 1024));
+    int ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout_ms);
+    for (int k = 0; k < ready; ++k) {
+        if (events[k].data.u64 == kInputTag) continue;
+        if (events[k].data.u64 == kResolverTag) {
+            apply_resolved();
+            continue;
+        }
+        size_t index = static_cast<size_t>(events[k].data.u64);
+        if (hosts[index].state == Host::Connecting) finish_connect(index);
+        else if (hosts[index].state == Host::Connected) receive(index);
+    }
+
+    now = Clock::now();
+    double seconds = std::chrono::duration<double>(now - rate_time).count();
+    if (seconds >= 1.0) {
+        byte_rate = (bytes_received - rate_bytes) / seconds;
+        frame_rate = (frames_received - rate_frames) / seconds;
+        rate_bytes = bytes_received;
+        rate_frames = frames_received;
+        rate_time = now;
+        overview_dirty = true;
+    }
+}
+
+bool FleetAggregator::poll(size_t index) {
+    if (index == 0) {
+        // Обзор пересобирается не чаще 4 раз в секунду, сколько бы агентов ни прислало данные
+        auto now = Clock::now();
+        if (!overview_dirty || now - overview_time < std::chrono::milliseconds(250)) return false;
+        build_overview();
+        overview_dirty = false;
+        overview_time = now;
+        return true;
+    }
+    Host& host = hosts[selected];
+    if (index > host.fresh.size() || !host.fresh[index - 1]) return false;
+    host.fresh[index - 1] = false;
+    return true;
+}
+
+bool FleetAggregator::has_sample(size_t index) const {
+    const Host& host = hosts[selected];
+    return index == 0 || (index <= host.present.size() && host.present[index - 1]);
+}
+
+const Snapshot& FleetAggregator::latest(size_t index) const {
+    return index == 0 ? overview : hosts[selected].snapshots[index - 1];
+}
+
+void FleetAggregator::select_next(int step) {
+    if (hosts.empty()) return;
+    size_t position = std::find(order.begin(), order.end(), selected) - order.begin();
+    size_t previous = selected;
+    selected = order[(position + order.size() + step) % order.size()];
+    if (selected == previous) return;
+    subscribe(previous);
+    subscribe(selected);
+    ++layout;
+    overview_dirty = true;
+    overview_time = {};
+}
+
+void FleetAggregator::cycle_sort() {
+    sort_key = static_cast<SortKey>((sort_key + 1) % kSortKeys);
+    overview_dirty = true;
+    overview_time = {};
+}
+
+void FleetAggregator::send_key(size_t section, int key) {
+    Host& host = hosts[selected];
+    if (host.state != Host::Connected || section >= host.sections.size()) return;
+    scratch.clear();
+    size_t start = fleet_format::begin_frame(scratch, 'K');
+    put_varint(scratch, section);
+    put_varint(scratch, static_cast<uint64_t>(key));
+    fleet_format::end_frame(scratch, start);
+    send_frame(selected, scratch);
+}
+
+void FleetAggregator::apply_resolved() {
+    resolved.clear();
+    resolver.collect(resolved);
+    for (const AddressResolver::Result& result : resolved) {
+        Host& host = hosts[result.id];
+        host.resolving = false;
+        if (!result.ok) {
+            drop(result.id, "cannot resolve the address");
+            continue;
+        }
+        host.storage = result.storage;
+        host.storage_length = result.length;
+        host.resolved = true;
+        connect_host(result.id);
+    }
+}
+
+void FleetAggregator::connect_host(size_t index) {
+    Host& host = hosts[index];
+    const sockaddr_storage& storage = host.storage;
+    const socklen_t length = host.storage_length;
+    host.fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (host.fd < 0) {
+        drop(index, strerror(errno));
+        return;
+    }
+    host.last_frame = Clock::now();
+    epoll_event event{};
+    event.data.u64 = index;
+    if (::connect(host.fd, reinterpret_cast<const sockaddr*>(&storage), length) == 0) {
+        event.events = EPOLLIN;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, host.fd, &event);
+        connected(index);
+    } else if (errno == EINPROGRESS) {
+        // Завершение подключения TCP приходит событием готовности к записи
+        event.events = EPOLLOUT;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, host.fd, &event);
+        host.state = Host::Connecting;
+    } else {
+        drop(index, strerror(errno));
+    }
+}
+
+void FleetAggregator::finish_connect(size_t index) {
+    Host& host = hosts[index];
+    int error = 0;
+    socklen_t size = sizeof(error);
+    if (getsockopt(host.fd, SOL_SOCKET, SO_ERROR, &error, &size) != 0) error = errno;
+    if (error != 0) {
+        drop(index, strerror(error));
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = index;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, host.fd, &event);
+    connected(index);
+}
+
+void FleetAggregator::connected(size_t index) {
+    Host& host = hosts[index];
+    host.state = Host::Connected;
+    host.last_frame = Clock::now();
+    host.error.clear();
+    host.filled = 0;
+    host.names.assign(1, 0); // 0 — поле без имени у обеих сторон
+    overview_dirty = true;
+    subscribe(index);
+}
+
+void FleetAggregator::drop(size_t index, std::string reason) {
+    Host& host = hosts[index];
+    if (host.fd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, host.fd, nullptr);
+        close(host.fd);
+        host.fd = -1;
+    }
+    host.state = Host::Waiting;
+    host.resolved = false;
+    host.error = std::move(reason);
+    host.retry = Clock::now() + host.backoff;
+    host.backoff = std::min(host.backoff * 2, kMaxBackoff);
+    overview_dirty = true;
+}
+
+void FleetAggregator::subscribe(size_t index) {
+    scratch.clear();
+    size_t start = fleet_format::begin_frame(scratch, 'W');
+    if (index == selected) {
+        put_varint(scratch, 1);
+        put_string(scratch, "*");
+    } else {
+        put_varint(scratch, 2);
+        put_string(scratch, "System Usage");
+        put_string(scratch, "Temperatures");
+    }
+    fleet_format::end_frame(scratch, start);
+    send_frame(index, scratch);
+}
+
+void FleetAggregator::send_frame(size_t index, const std::string& frame) {
+    Host& host = hosts[index];
+    if (host.state != Host::Connected) return;
+    ssize_t count = send(host.fd, frame.data(), frame.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (count != static_cast<ssize_t>(frame.size())) drop(index, count < 0 ? strerror(errno) : "send buffer full");
+}
+
+void FleetAggregator::receive(size_t index) {
+    Host& host = hosts[index];
+    // Несколько чтений за событие, чтобы один болтливый агент не задерживал остальных надолго
+    for (int round = 0; round < 4; ++round) {
+        if (host.buffer.size() - host.filled < kReadChunk) host.buffer.resize(host.filled + kReadChunk);
+        const size_t room = host.buffer.size() - host.filled;
+        ssize_t count = read(host.fd, host.buffer.data() + host.filled, room);
+        if (count == 0) {
+            drop(index, "connection closed");
+            return;
+        }
+        if (count < 0) {
+            if (errno != EAGAIN && errno != EINTR) drop(index, strerror(errno));
+            return;
+        }
+        host.filled += count;
+        bytes_received += count;
+
+        std::string_view in(host.buffer.data(), host.filled);
+        char type;
+        std::string_view payload;
+        fleet_format::FrameStatus status;
+        while ((status = fleet_format::next_frame(in, type, payload)) == fleet_format::FrameStatus::Ready) {
+            ++frames_received;
+            if (!handle_frame(index, type, payload)) {
+                drop(index, "protocol error");
+                return;
+            }
+        }
+        if (status == fleet_format::FrameStatus::Corrupt) {
+            drop(index, "protocol error");
+            return;
+        }
+        if (in.size() != host.filled) {
+            memmove(host.buffer.data(), in.data(), in.size());
+            host.filled = in.size();
+        }
+        host.last_frame = Clock::now();
+        if (static_cast<size_t>(count) < room) return; // сокет прочитан до конца
+    }
+}
+
+bool FleetAggregator::handle_frame(size_t index, char type, std::string_view payload) {
+    Host& host = hosts[index];
+    switch (type) {
+        case 'H': {
+            uint64_t version, count;
+            std::string_view name;
+            if (!get_varint(payload, version) || version != fleet_format::kVersion || !get_string(payload, name) ||
+                !get_varint(payload, count) || count > 256) {
+                return false;
+            }
+            host.name.assign(name);
+            host.sections.clear();
+            for (uint64_t i = 0; i < count; ++i) {
+                std::string_view section;
+                if (!get_string(payload, section)) return false;
+                host.sections.emplace_back(section);
+            }
+            host.snapshots.assign(count, Snapshot());
+            host.present.assign(count, false);
+            host.fresh.assign(count, false);
+            auto find = [&](std::string_view section) {
+                auto it = std::find(host.sections.begin(), host.sections.end(), section);
+                return it == host.sections.end() ? -1 : static_cast<int>(it - host.sections.begin());
+            };
+            host.usage_section = find("System Usage");
+            host.temperature_section = find("Temperatures");
+            host.backoff = kInitialBackoff; // агент ответил — следующий обрыв переподключается быстро
+            if (index == selected) ++layout;
+            overview_dirty = true;
+            return true;
+        }
+        case 'N': {
+            uint32_t count;
+            if (!get_raw(payload, count)) return false;
+            for (uint32_t i = 0; i < count; ++i) {
+                uint64_t remote;
+                std::string_view name;
+                if (!get_varint(payload, remote) || remote >= kMaxNames || !get_string(payload, name)) return false;
+                if (remote >= host.names.size()) host.names.resize(remote + 1, fleet_format::kUnknownName);
+                host.names[remote] = metric_name(name);
+            }
+            return true;
+        }
+        case 'S': {
+            uint64_t section;
+            if (!get_varint(payload, section) || section >= host.snapshots.size()) return false;
+            Snapshot& snapshot = host.snapshots[section];
+            snapshot.clear();
+            if (!fleet_format::get_fields(payload, host.names, snapshot)) return false;
+            host.present[section] = host.fresh[section] = true;
+            if (static_cast<int>(section) == host.usage_section) read_usage(host, snapshot);
+            if (static_cast<int>(section) == host.temperature_section) read_temperature(host, snapshot);
+            return true;
+        }
+    }
+    return true; // неизвестные кадры пропускаются ради совместимости с новыми агентами
+}
+
+void FleetAggregator::read_usage(Host& host, const Snapshot& snapshot) {
+    static const uint32_t cpu_usage_name = metric_name("CPU Usage");
+    static const uint32_t mem_usage_name = metric_name("Memory Usage");
+    host.cpu = host.memory = NAN;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind != FieldKind::Number) continue;
+        if (field.name == cpu_usage_name && std::isnan(host.cpu)) host.cpu = field.value.number;
+        else if (field.name == mem_usage_name && std::isnan(host.memory)) host.memory = field.value.number;
+    }
+    overview_dirty = true;
+}
+
+void FleetAggregator::read_temperature(Host& host, const Snapshot& snapshot) {
+    host.temperature = NAN;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind != FieldKind::Number || field.unit != Unit::MilliCelsius || !(field.flags & kFieldHistory)) continue;
+        if (std::isnan(host.temperature) || field.value.number > host.temperature) host.temperature = field.value.number;
+    }
+    overview_dirty = true;
+}
+
+void FleetAggregator::build_overview() {
+    static const char* const sort_names[] = {"CPU", "memory", "temperature", "name"};
+    static const uint32_t hosts_name = metric_name("Hosts");
+    static const uint32_t connected_name = metric_name("Connected");
+    static const uint32_t received_name = metric_name("Received");
+    static const uint32_t frames_name = metric_name("Frames");
+    static const uint32_t address_name = metric_name("Address");
+    static const uint32_t cpu_name = metric_name("CPU");
+    static const uint32_t memory_name = metric_name("Memory");
+    static const uint32_t temperature_name = metric_name("Temperature");
+    static const uint32_t state_name = metric_name("State");
+
+    // Хосты без значения уходят в конец при любой сортировке
+    auto value = [this](const Host& host) {
+        double v = sort_key == SortCpu ? host.cpu : sort_key == SortMemory ? host.memory : host.temperature;
+        return std::isnan(v) ? -1.0 : v;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (sort_key == SortName) return hosts[a].name < hosts[b].name;
+        return value(hosts[a]) > value(hosts[b]);
+    });
+
+    size_t connected = std::count_if(hosts.begin(), hosts.end(), [](const Host& host) { return host.state == Host::Connected; });
+    overview.clear();
+    overview.number(hosts_name, hosts.size(), Unit::Count);
+    overview.number(connected_name, connected, Unit::Count, kFieldInline);
+    overview.number(received_name, byte_rate, Unit::BytesPerSecond, kFieldInline);
+    overview.number(frames_name, frame_rate, Unit::PerSecond, kFieldInline);
+    overview.separator();
+
+    char line[160];
+    snprintf(line, sizeof(line), "Sorted by %s ('s' to change), 'n'/'p' to select a host, Enter to open it:", sort_names[sort_key]);
+    overview.heading(line);
+    snprintf(line, sizeof(line), "%-24s   %-24s   %-8s   %-8s   %-8s   %s", "  HOST", "ADDRESS", "CPU", "MEMORY", "TEMP", "STATE");
+    overview.heading(line);
+
+    auto now = Clock::now();
+    std::string row;
+    for (size_t index : order) {
+        const Host& host = hosts[index];
+        row.assign(index == selected ? "> " : "  ");
+        row += host.name;
+        overview.text(0, row, kFieldRowKey, 24);
+        overview.text(address_name, host.address, kFieldInline | kFieldNoLabel, 24);
+        const std::pair<uint32_t, double> cells[] = {{cpu_name, host.cpu}, {memory_name, host.memory}};
+        for (const auto& cell : cells) {
+            if (std::isnan(cell.second)) overview.text(cell.first, "-", kFieldInline | kFieldNoLabel, 8);
+            else overview.number(cell.first, cell.second, Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+        }
+        if (std::isnan(host.temperature)) overview.text(temperature_name, "-", kFieldInline | kFieldNoLabel, 8);
+        else overview.number(temperature_name, host.temperature, Unit::MilliCelsius, kFieldInline | kFieldNoLabel, 8);
+
+        switch (host.state) {
+            case Host::Connected: {
+                auto idle = std::chrono::duration_cast<std::chrono::seconds>(now - host.last_frame).count();
+                row = idle >= 3 ? "idle " + std::to_string(idle) + " s" : "ok";
+                break;
+            }
+            case Host::Connecting:
+                row = "connecting";
+                break;
+            case Host::Waiting: {
+                if (host.resolving) {
+                    row = "resolving";
+                    break;
+                }
+                auto wait = std::chrono::duration_cast<std::chrono::seconds>(host.retry - now).count();
+                row = "retry in " + std::to_string(std::max<long long>(wait, 0)) + " s: " + host.error;
+                break;
+            }
+        }
+        overview.text(state_name, row, kFieldInline | kFieldNoLabel);
+    }
+}
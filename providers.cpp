@@ -0,0 +1,2503 @@
+// Провайдеры разделов и функции слоя сбора данных, объявленные в sysinfo.h
+#include "sysinfo.h"
+
+std::string command_output(const CommandResult& result) {
+    if (result.output.empty()) return "Error: command timed out or failed";
+    return result.output;
+}
+
+std::string exec_command(const char* cmd, int timeout_seconds) {
+    CommandRunner runner;
+    size_t index = runner.start(cmd, timeout_seconds * 1000);
+    runner.wait_all();
+    return command_output(runner.result(index));
+}
+
+bool is_utility_installed(const std::string& util) {
+    // Ищем по PATH, как и /bin/sh при запуске; стандартные каталоги проверяются всегда
+    std::string dirs = "/usr/sbin:/usr/bin";
+    if (const char* path = getenv("PATH")) dirs = std::string(path) + ":" + dirs;
+    std::string_view rest = dirs;
+    while (!rest.empty()) {
+        size_t colon = rest.find(':');
+        std::string candidate(rest.substr(0, colon));
+        rest = colon == std::string_view::npos ? std::string_view() : rest.substr(colon + 1);
+        if (candidate.empty()) continue;
+        candidate += '/';
+        candidate += util;
+        if (access(candidate.c_str(), X_OK) == 0) return true;
+    }
+    return false;
+}
+
+std::string read_text_file(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return "";
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    SelfStats::thread_bytes_read += content.size();
+    while (!content.empty() && (content.back() == '\n' || content.back() == ' ')) content.pop_back();
+    return content;
+}
+
+std::string pci_device_name(uint32_t vendor, uint32_t device) {
+    char fallback[48];
+    snprintf(fallback, sizeof(fallback), "PCI device %04x:%04x", vendor, device);
+    std::ifstream ids("/usr/share/hwdata/pci.ids");
+    if (!ids.is_open()) ids.open("/usr/share/misc/pci.ids");
+    char vendor_id[8], device_id[8];
+    snprintf(vendor_id, sizeof(vendor_id), "%04x  ", vendor);
+    snprintf(device_id, sizeof(device_id), "\t%04x  ", device);
+    std::string line, vendor_name;
+    while (std::getline(ids, line)) {
+        if (vendor_name.empty()) {
+            if (line.compare(0, 6, vendor_id) == 0) vendor_name = line.substr(6);
+        } else if (line.compare(0, 7, device_id) == 0) {
+            return vendor_name + " " + line.substr(7);
+        } else if (!line.empty() && line[0] != '\t' && line[0] != '#') {
+            break; // начался следующий производитель
+        }
+    }
+    return vendor_name.empty() ? fallback : vendor_name + " " + (fallback + 4);
+}
+
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    const char* p = list.c_str();
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) cpus.push_back(static_cast<int>(cpu));
+        if (*p == ',') ++p;
+        else break;
+    }
+    return cpus;
+}
+
+double counter_rate(uint64_t previous, uint64_t current, double elapsed) {
+    uint64_t base = current >= previous ? previous : 0;
+    return elapsed > 0 ? (current - base) / elapsed : 0.0;
+}
+
+void append_key_value_line(Snapshot& out, std::string_view line) {
+    size_t begin = line.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) return;
+    line.remove_prefix(begin);
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\r')) line.remove_suffix(1);
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon + 1 == line.size() || line[colon + 1] != ' ') {
+        out.message(line);
+        return;
+    }
+    std::string_view value = line.substr(colon + 1);
+    value.remove_prefix(std::min(value.find_first_not_of(" \t"), value.size()));
+    out.text(metric_name(line.substr(0, colon)), value);
+}
+
+void append_lines(Snapshot& out, std::string_view text) {
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        out.message(line);
+        if (end == std::string_view::npos) break;
+        text.remove_prefix(end + 1);
+    }
+}
+
+void put_string(std::string& out, std::string_view text) {
+    put_raw<uint32_t>(out, static_cast<uint32_t>(text.size()));
+    out.append(text);
+}
+
+bool get_string(std::string_view& in, std::string_view& text) {
+    uint32_t size;
+    if (!get_raw(in, size) || in.size() < size) return false;
+    text = in.substr(0, size);
+    in.remove_prefix(size);
+    return true;
+}
+
+bool parse_socket_address(const std::string& address, sockaddr_storage& storage, socklen_t& length) {
+    memset(&storage, 0, sizeof(storage));
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un* sun = reinterpret_cast<sockaddr_un*>(&storage);
+        const std::string path = address.substr(5);
+        if (path.empty() || path.size() >= sizeof(sun->sun_path)) return false;
+        sun->sun_family = AF_UNIX;
+        memcpy(sun->sun_path, path.c_str(), path.size() + 1);
+        length = sizeof(sockaddr_un);
+        return true;
+    }
+    size_t colon = address.rfind(':');
+    std::string host = colon == std::string::npos ? std::string() : address.substr(0, colon);
+    std::string port = colon == std::string::npos ? address : address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+    if (host.empty()) host = "127.0.0.1";
+    int number = atoi(port.c_str());
+    if (number <= 0 || number > 65535) return false;
+
+    addrinfo hints{};
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || !result) return false;
+    memcpy(&storage, result->ai_addr, result->ai_addrlen);
+    length = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+void serialize_snapshot(std::string& out, const Snapshot& snapshot) {
+    MetricNames& names = MetricNames::instance();
+    put_raw<uint32_t>(out, static_cast<uint32_t>(snapshot.items().size()));
+    for (const Field& field : snapshot.items()) {
+        put_string(out, names.name(field.name));
+        put_raw(out, static_cast<uint8_t>(field.unit));
+        put_raw(out, static_cast<uint8_t>(field.kind));
+        put_raw(out, field.flags);
+        put_raw(out, field.width);
+        if (field.kind == FieldKind::Number) put_raw(out, field.value.number);
+        else if (field.kind != FieldKind::Separator) put_string(out, snapshot.text_of(field));
+    }
+}
+
+bool deserialize_snapshot(std::string_view& in, Snapshot& out) {
+    uint32_t count;
+    if (!get_raw(in, count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view name, text;
+        uint8_t unit, kind, flags, width;
+        if (!get_string(in, name) || !get_raw(in, unit) || !get_raw(in, kind) || !get_raw(in, flags) || !get_raw(in, width)) {
+            return false;
+        }
+        switch (static_cast<FieldKind>(kind)) {
+            case FieldKind::Number: {
+                double value;
+                if (!get_raw(in, value)) return false;
+                out.number(metric_name(name), value, static_cast<Unit>(unit), flags, width);
+                break;
+            }
+            case FieldKind::Text:
+                if (!get_string(in, text)) return false;
+                out.text(metric_name(name), text, flags, width);
+                break;
+            case FieldKind::Heading:
+                if (!get_string(in, text)) return false;
+                out.heading(text);
+                break;
+            case FieldKind::Separator:
+                out.separator();
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void format_number(double value, Unit unit, char* buf, size_t size) {
+    static const char* const byte_units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB"};
+    switch (unit) {
+        case Unit::Percent:
+            snprintf(buf, size, "%.2f%%", value);
+            break;
+        case Unit::Bytes:
+        case Unit::BytesPerSecond: {
+            int index = 0;
+            while (std::fabs(value) >= 1024.0 && index < 5) {
+                value /= 1024.0;
+                ++index;
+            }
+            const char* suffix = unit == Unit::BytesPerSecond ? "/s" : "";
+            if (index == 0) snprintf(buf, size, "%.0f %s%s", value, byte_units[index], suffix);
+            else snprintf(buf, size, "%.1f %s%s", value, byte_units[index], suffix);
+            break;
+        }
+        case Unit::PerSecond:
+            snprintf(buf, size, "%.1f/s", value);
+            break;
+        case Unit::KiloHertz:
+            snprintf(buf, size, "%.0f MHz", value / 1000.0);
+            break;
+        case Unit::MilliCelsius:
+            snprintf(buf, size, "%+.1f C", value / 1000.0);
+            break;
+        case Unit::Rpm:
+            snprintf(buf, size, "%.0f RPM", value);
+            break;
+        case Unit::MicroWatts:
+            snprintf(buf, size, "%.2f W", value / 1000000.0);
+            break;
+        case Unit::Milliseconds:
+            snprintf(buf, size, "%.2f ms", value);
+            break;
+        case Unit::Microseconds:
+            if (value < 1000.0) snprintf(buf, size, "%.0f us", value);
+            else if (value < 1000000.0) snprintf(buf, size, "%.2f ms", value / 1000.0);
+            else snprintf(buf, size, "%.2f s", value / 1000000.0);
+            break;
+        case Unit::Count:
+            snprintf(buf, size, "%.0f", value);
+            break;
+        case Unit::None:
+            snprintf(buf, size, "%g", value);
+            break;
+    }
+}
+
+void format_snapshot(const Snapshot& snapshot, std::string& out) {
+    out.clear();
+    MetricNames& names = MetricNames::instance();
+    bool line_open = false;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind == FieldKind::Separator) {
+            if (line_open) out += '\n';
+            out += "-------------------\n";
+            line_open = false;
+            continue;
+        }
+        if ((field.flags & kFieldHeat) && field.kind == FieldKind::Number) {
+            static const char ramp[] = "_.:-=+*#%@";
+            int level = static_cast<int>(field.value.number / 10.0);
+            if (!line_open) out += ' ';
+            out += ramp[std::clamp(level, 0, 9)];
+            line_open = true;
+            continue;
+        }
+        size_t cell_start;
+        if ((field.flags & kFieldInline) && line_open) {
+            out += "   ";
+            cell_start = out.size();
+        } else {
+            if (line_open) out += '\n';
+            cell_start = out.size();
+        }
+        line_open = true;
+        if (field.kind == FieldKind::Heading) {
+            out += snapshot.text_of(field);
+            continue;
+        }
+        if (field.name != 0 && !(field.flags & kFieldNoLabel)) {
+            out += names.name(field.name);
+            out += ": ";
+        }
+        if (field.kind == FieldKind::Number) {
+            char buf[48];
+            format_number(field.value.number, field.unit, buf, sizeof(buf));
+            out += buf;
+        } else {
+            out += snapshot.text_of(field);
+        }
+        if (field.width > 0 && out.size() - cell_start < field.width) {
+            out.append(field.width - (out.size() - cell_start), ' ');
+        }
+    }
+    if (line_open) out += '\n';
+}
+
+void append_history(std::string& out, HistoryStore& history, size_t provider, HistoryStore::Resolution resolution, int width) {
+    static const char* const resolution_names[] = {"raw samples", "1 min min/avg/max", "15 min min/avg/max"};
+    static const char ramp[] = "_.:-=+*#%@";
+    static thread_local std::vector<size_t> series;
+    static thread_local std::vector<float> values;
+
+    history.series_of(provider, series);
+    if (series.empty() || width < 8) return;
+    values.resize(std::max(values.size(), static_cast<size_t>(width)));
+
+    if (out.size() < 20 || out.compare(out.size() - 20, 20, "-------------------\n") != 0) out += "-------------------\n";
+    out += "History (";
+    out += resolution_names[resolution];
+    out += ", 'h' to change):\n";
+    MetricNames& names = MetricNames::instance();
+    for (size_t index : series) {
+        HistoryStore::Rollup window;
+        uint32_t name;
+        Unit unit;
+        size_t count = history.read(index, resolution, values.data(), width - 2, window, name, unit);
+        char low[32], mean[32], high[32];
+        format_number(window.min, unit, low, sizeof(low));
+        format_number(window.avg, unit, mean, sizeof(mean));
+        format_number(window.max, unit, high, sizeof(high));
+        out += names.name(name);
+        out += ": min ";
+        out += low;
+        out += "  avg ";
+        out += mean;
+        out += "  max ";
+        out += high;
+        out += "\n [";
+        // Проценты масштабируются на 0..100, остальные метрики — на диапазон окна
+        float floor = unit == Unit::Percent ? 0.0f : window.min;
+        float span = unit == Unit::Percent ? 100.0f : window.max - window.min;
+        for (size_t i = 0; i < count; ++i) {
+            int level = span > 0 ? static_cast<int>((values[i] - floor) / span * 9.999f) : 0;
+            out += ramp[std::clamp(level, 0, 9)];
+        }
+        out += "]\n";
+    }
+}
+
+void on_device_change(const std::vector<std::unique_ptr<InfoProvider>>& providers, SamplingScheduler& scheduler,
+                      std::string_view subsystem) {
+    InventoryCache::instance().invalidate_subsystem(subsystem);
+    for (size_t i = 0; i < providers.size(); ++i) {
+        if (!providers[i]->dependsOn(subsystem)) continue;
+        providers[i]->invalidate();
+        scheduler.request(i);
+    }
+}
+
+void make_providers(std::vector<std::unique_ptr<InfoProvider>>& providers, std::vector<std::string>& names,
+                    const InterfaceFilter& interfaces, const std::string& root) {
+    providers.push_back(std::make_unique<CPUInfoProvider>(root));
+    providers.push_back(std::make_unique<SystemUsageProvider>(root));
+    providers.push_back(std::make_unique<TemperaturesProvider>(root));
+    providers.push_back(std::make_unique<MotherboardProvider>());
+    providers.push_back(std::make_unique<MemoryProvider>());
+    providers.push_back(std::make_unique<PressureProvider>(root));
+    providers.push_back(std::make_unique<DisksProvider>(root));
+    providers.push_back(std::make_unique<NetworkProvider>(interfaces, root));
+    providers.push_back(std::make_unique<GPUProvider>(root));
+    providers.push_back(std::make_unique<ProcessesProvider>(root));
+    providers.push_back(std::make_unique<CgroupsProvider>(root));
+    names = {"CPU", "System Usage", "Temperatures", "Motherboard", "Memory", "Pressure", "Disks", "Network", "GPU", "Processes", "Cgroups"};
+}
+
+bool MeminfoReader::update() {
+    std::string_view text = file.read();
+    if (text.empty()) return false;
+    std::string_view line;
+    while (next_line(text, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view key = line.substr(0, colon);
+        for (int i = 0; i < kKeys; ++i) {
+            if (key != kNames[i]) continue;
+            const char* p = line.data() + colon + 1;
+            values[i] = 0;
+            parse_u64(p, line.data() + line.size(), values[i]);
+            break;
+        }
+    }
+    return values[MemTotal] > 0;
+}
+
+InventoryCache& InventoryCache::instance() {
+    static InventoryCache cache;
+    return cache;
+}
+
+bool InventoryCache::get(std::string_view key, Snapshot& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end() || (it->second.uid == 0 && getuid() != 0)) return false;
+    std::string_view data = it->second.data;
+    return deserialize_snapshot(data, out);
+}
+
+void InventoryCache::put(std::string_view key, std::string_view subsystem, const Snapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries[std::string(key)];
+    entry.subsystem.assign(subsystem);
+    entry.uid = getuid();
+    entry.data.clear();
+    serialize_snapshot(entry.data, snapshot);
+    save();
+}
+
+void InventoryCache::invalidate(std::string_view key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) return;
+    entries.erase(it);
+    save();
+}
+
+void InventoryCache::invalidate_subsystem(std::string_view subsystem) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool removed = false;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.subsystem == subsystem) {
+            it = entries.erase(it);
+            removed = true;
+        } else {
+            ++it;
+        }
+    }
+    if (removed) save();
+}
+
+InventoryCache::InventoryCache() {
+    boot_id = read_text_file("/proc/sys/kernel/random/boot_id");
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    // sudo часто оставляет HOME пользователя: кэш root не должен появляться в чужом каталоге с владельцем root
+    if (geteuid() == 0 && getenv("SUDO_UID")) {
+        const passwd* account = getpwuid(0);
+        cache_home = nullptr;
+        home = account ? account->pw_dir : nullptr;
+    }
+    if (cache_home && *cache_home) path = std::string(cache_home) + "/sysinfo";
+    else if (home && *home) path = std::string(home) + "/.cache/sysinfo";
+    if (!path.empty()) path += "/inventory.bin";
+    load();
+}
+
+void InventoryCache::load() {
+    if (path.empty() || boot_id.empty()) return;
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string_view in = content;
+    std::string_view stored_boot_id;
+    uint32_t count;
+    if (in.substr(0, sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic))) return;
+    in.remove_prefix(sizeof(kMagic));
+    if (!get_string(in, stored_boot_id) || stored_boot_id != boot_id || !get_raw(in, count)) return;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view key, subsystem, data;
+        uint32_t uid;
+        if (!get_string(in, key) || !get_string(in, subsystem) || !get_string(in, data) || !get_raw(in, uid)) {
+            entries.clear();
+            return;
+        }
+        entries[std::string(key)] = Entry{std::string(subsystem), std::string(data), uid};
+    }
+}
+
+void InventoryCache::save() {
+    if (path.empty() || boot_id.empty()) return;
+    std::string content(kMagic, sizeof(kMagic));
+    put_string(content, boot_id);
+    put_raw<uint32_t>(content, static_cast<uint32_t>(entries.size()));
+    for (const auto& item : entries) {
+        put_string(content, item.first);
+        put_string(content, item.second.subsystem);
+        put_string(content, item.second.data);
+        put_raw<uint32_t>(content, item.second.uid);
+    }
+    // Каталог и файл доступны только владельцу; O_EXCL не даёт пройти по подложенной ссылке
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    std::error_code ec;
+    std::filesystem::create_directories(dir.parent_path(), ec);
+    mkdir(dir.c_str(), 0700);
+    std::string tmp = path + ".tmp." + std::to_string(getpid());
+    unlink(tmp.c_str());
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return;
+    size_t done = 0;
+    while (done < content.size()) {
+        ssize_t count = write(fd, content.data() + done, content.size() - done);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        done += count;
+    }
+    close(fd);
+    if (done != content.size() || rename(tmp.c_str(), path.c_str()) != 0) unlink(tmp.c_str());
+}
+
+UeventMonitor::UeventMonitor(std::function<void(std::string_view)> on_change) : on_change(std::move(on_change)) {
+    sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1; // события ядра
+    if (sock >= 0 && bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(sock);
+        sock = -1;
+    }
+    if (sock < 0 || pipe2(wake, O_CLOEXEC) != 0) return;
+    thread = std::thread([this] { loop(); });
+}
+
+UeventMonitor::~UeventMonitor() {
+    if (thread.joinable()) {
+        char byte = 0;
+        if (write(wake[1], &byte, 1) < 0) {}
+        thread.join();
+    }
+    if (wake[0] >= 0) close(wake[0]);
+    if (wake[1] >= 0) close(wake[1]);
+    if (sock >= 0) close(sock);
+}
+
+void UeventMonitor::loop() {
+    char buf[8192];
+    pollfd fds[2] = {{sock, POLLIN, 0}, {wake[0], POLLIN, 0}};
+    while (poll(fds, 2, -1) >= 0 || errno == EINTR) {
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+        ssize_t count = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (count <= 0) continue;
+        // Сообщение: "action@devpath\0KEY=value\0KEY=value\0..."
+        std::string_view message(buf, count);
+        std::string_view action, subsystem;
+        while (!message.empty()) {
+            size_t end = message.find('\0');
+            std::string_view item = message.substr(0, end);
+            if (item.compare(0, 7, "ACTION=") == 0) action = item.substr(7);
+            else if (item.compare(0, 10, "SUBSYSTEM=") == 0) subsystem = item.substr(10);
+            if (end == std::string_view::npos) break;
+            message.remove_prefix(end + 1);
+        }
+        // bind/unbind драйверов и change на блочных устройствах тоже меняют вывод утилит
+        if (!subsystem.empty() && !action.empty()) on_change(subsystem);
+    }
+}
+
+void CPUInfoProvider::sample(Snapshot& out) {
+    if (!topology_loaded) {
+        load_topology();
+        topology_loaded = true;
+    }
+    if (cpus.empty()) {
+        out.message("Error: cannot read " + root + "/sys/devices/system/cpu");
+        out.message("CPU topology is unavailable");
+        return;
+    }
+
+    out.append(topology);
+    if (freq_files.empty()) {
+        out.text(metric_name("Per-core frequency"), "unavailable (no cpufreq)");
+        return;
+    }
+
+    uint64_t min_khz = UINT64_MAX, max_khz = 0, sum_khz = 0;
+    size_t valid = 0;
+    for (size_t i = 0; i < freq_files.size(); ++i) {
+        uint64_t khz = 0;
+        if (!freq_files[i].read_u64(khz)) khz = 0;
+        freq_khz[i] = khz;
+        if (khz == 0) continue;
+        min_khz = std::min(min_khz, khz);
+        max_khz = std::max(max_khz, khz);
+        sum_khz += khz;
+        ++valid;
+    }
+    if (valid > 0) {
+        static const uint32_t min_name = metric_name("CPU frequency min");
+        static const uint32_t avg_name = metric_name("avg");
+        static const uint32_t max_name = metric_name("max");
+        out.number(min_name, min_khz, Unit::KiloHertz);
+        out.number(avg_name, static_cast<double>(sum_khz) / valid, Unit::KiloHertz, kFieldInline);
+        out.number(max_name, max_khz, Unit::KiloHertz, kFieldInline);
+    }
+    out.separator();
+    static const uint32_t frequency_name = metric_name("frequency");
+    out.heading("Per-core frequency:");
+    for (size_t i = 0; i < freq_files.size(); ++i) {
+        out.text(0, freq_labels[i], (i % 4 == 0 ? 0 : kFieldInline) | kFieldRowKey, 5);
+        out.number(frequency_name, freq_khz[i], Unit::KiloHertz, kFieldInline | kFieldNoLabel, 9);
+    }
+}
+
+std::string CPUInfoProvider::cpu_dir(int cpu) const {
+    return root + "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+}
+
+void CPUInfoProvider::load_topology() {
+    const std::string base = root + "/sys/devices/system/cpu";
+    cpus = parse_cpu_list(read_text_file(base + "/online"));
+    if (cpus.empty()) return;
+
+    // Сокеты, ядра и потоки на ядро
+    std::vector<std::pair<long, long>> cores;
+    std::vector<long> sockets;
+    size_t max_siblings = 1;
+    for (int cpu : cpus) {
+        const std::string topo = cpu_dir(cpu) + "/topology/";
+        long package = strtol(read_text_file(topo + "physical_package_id").c_str(), nullptr, 10);
+        long core = strtol(read_text_file(topo + "core_id").c_str(), nullptr, 10);
+        cores.emplace_back(package, core);
+        sockets.push_back(package);
+        max_siblings = std::max(max_siblings, parse_cpu_list(read_text_file(topo + "thread_siblings_list")).size());
+    }
+    std::sort(cores.begin(), cores.end());
+    cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+    std::sort(sockets.begin(), sockets.end());
+    sockets.erase(std::unique(sockets.begin(), sockets.end()), sockets.end());
+
+    std::string model = cpu_model_name();
+    if (!model.empty()) topology.text(metric_name("Model name"), model);
+    topology.number(metric_name("CPU(s)"), cpus.size(), Unit::Count);
+    topology.number(metric_name("Socket(s)"), sockets.size(), Unit::Count);
+    topology.number(metric_name("Core(s) per socket"), cores.size() / std::max<size_t>(1, sockets.size()), Unit::Count);
+    topology.number(metric_name("Thread(s) per core"), max_siblings, Unit::Count);
+    topology.separator();
+    append_cache_info();
+    append_numa_info();
+
+    uint64_t max_khz = 0;
+    for (int cpu : cpus) {
+        PreadFile file(cpu_dir(cpu) + "/cpufreq/scaling_cur_freq");
+        if (!file.is_open()) continue;
+        if (max_khz == 0) {
+            max_khz = strtoull(read_text_file(cpu_dir(cpu) + "/cpufreq/cpuinfo_max_freq").c_str(), nullptr, 10);
+        }
+        freq_files.push_back(std::move(file));
+        freq_labels.push_back("cpu" + std::to_string(cpu));
+    }
+    freq_khz.assign(freq_files.size(), 0);
+    if (max_khz > 0) topology.number(metric_name("CPU max frequency"), max_khz, Unit::KiloHertz);
+}
+
+std::string CPUInfoProvider::cpu_model_name() const {
+    std::ifstream cpuinfo(root + "/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(" \t", colon + 1));
+        }
+    }
+    return "";
+}
+
+void CPUInfoProvider::append_cache_info() {
+    struct Cache {
+        std::string name, size;
+        std::vector<std::string> shared;
+    };
+    std::vector<Cache> caches;
+    for (int cpu : cpus) {
+        for (int index = 0;; ++index) {
+            const std::string dir = cpu_dir(cpu) + "/cache/index" + std::to_string(index) + "/";
+            std::string level = read_text_file(dir + "level");
+            if (level.empty()) break;
+            std::string type = read_text_file(dir + "type");
+            std::string name = "L" + level + (type == "Data" ? "d" : type == "Instruction" ? "i" : "");
+            std::string shared = read_text_file(dir + "shared_cpu_list");
+            auto it = std::find_if(caches.begin(), caches.end(), [&](const Cache& c) { return c.name == name; });
+            if (it == caches.end()) {
+                caches.push_back({name, read_text_file(dir + "size"), {}});
+                it = caches.end() - 1;
+            }
+            if (std::find(it->shared.begin(), it->shared.end(), shared) == it->shared.end()) {
+                it->shared.push_back(shared);
+            }
+        }
+    }
+    for (const Cache& cache : caches) {
+        topology.text(metric_name(cache.name + " cache"), cache.size + " x " + std::to_string(cache.shared.size()));
+    }
+    if (!caches.empty()) topology.separator();
+}
+
+void CPUInfoProvider::append_numa_info() {
+    const std::string base = root + "/sys/devices/system/node/";
+    std::vector<int> nodes = parse_cpu_list(read_text_file(base + "online"));
+    for (int node : nodes) {
+        topology.text(metric_name("NUMA node" + std::to_string(node) + " CPU(s)"),
+                      read_text_file(base + "node" + std::to_string(node) + "/cpulist"));
+    }
+    if (!nodes.empty()) topology.separator();
+}
+
+bool CpuLoadEngine::update(const std::string& path) {
+    if (!stat_file.is_open() && !stat_file.open(path)) return false;
+    std::string_view text = stat_file.read();
+
+    size_t row = 0;
+    bool layout_changed = false;
+    std::string_view line;
+    while (next_line(text, line)) {
+        if (line.compare(0, 3, "cpu") != 0) break;
+        const char* p = line.data() + 3;
+        const char* end = line.data() + line.size();
+        int id = -1;
+        if (*p != ' ') p = std::from_chars(p, end, id).ptr;
+        if (row >= ids.size()) {
+            ids.push_back(id);
+            for (auto& column : current) column.push_back(0);
+            layout_changed = true;
+        } else if (ids[row] != id) {
+            ids[row] = id;
+            layout_changed = true;
+        }
+        // guest и guest_nice уже учтены в user и nice, поэтому не читаются
+        for (int column = 0; column < kColumns; ++column) {
+            uint64_t value = 0;
+            parse_u64(p, end, value);
+            current[column][row] = value;
+        }
+        ++row;
+    }
+    if (row != ids.size()) {
+        ids.resize(row);
+        for (auto& column : current) column.resize(row);
+        layout_changed = true;
+    }
+    // При смене набора процессоров (hotplug) первая разность берётся от нуля,
+    // то есть показывает среднюю загрузку с момента загрузки системы
+    if (layout_changed) {
+        for (auto& column : previous) column.assign(row, 0);
+        for (auto& share : shares) share.resize(row);
+    }
+    compute();
+    return row > 0;
+}
+
+void CpuLoadEngine::compute() {
+    const size_t n = ids.size();
+    const uint64_t* __restrict cur[kColumns];
+    const uint64_t* __restrict prev[kColumns];
+    for (int column = 0; column < kColumns; ++column) {
+        cur[column] = current[column].data();
+        prev[column] = previous[column].data();
+    }
+    float* __restrict out[kShares];
+    for (int share = 0; share < kShares; ++share) out[share] = shares[share].data();
+
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t user = delta(cur[User][i], prev[User][i]) + delta(cur[Nice][i], prev[Nice][i]);
+        uint64_t system = delta(cur[System][i], prev[System][i]);
+        uint64_t idle = delta(cur[Idle][i], prev[Idle][i]);
+        uint64_t iowait = delta(cur[IoWait][i], prev[IoWait][i]);
+        uint64_t irq = delta(cur[Irq][i], prev[Irq][i]);
+        uint64_t softirq = delta(cur[SoftIrq][i], prev[SoftIrq][i]);
+        uint64_t steal = delta(cur[Steal][i], prev[Steal][i]);
+        uint64_t total = user + system + idle + iowait + irq + softirq + steal;
+        float scale = total ? 100.0f / static_cast<float>(total) : 0.0f;
+        out[ShareUser][i] = static_cast<float>(user) * scale;
+        out[ShareSystem][i] = static_cast<float>(system) * scale;
+        out[ShareIoWait][i] = static_cast<float>(iowait) * scale;
+        out[ShareIrq][i] = static_cast<float>(irq) * scale;
+        out[ShareSoftIrq][i] = static_cast<float>(softirq) * scale;
+        out[ShareSteal][i] = static_cast<float>(steal) * scale;
+        out[ShareBusy][i] = static_cast<float>(total - idle - iowait) * scale;
+    }
+    for (int column = 0; column < kColumns; ++column) std::swap(current[column], previous[column]);
+}
+
+void SystemUsageProvider::sample(Snapshot& out) {
+    static const uint32_t cpu_usage_name = metric_name("CPU Usage");
+    static const uint32_t mem_usage_name = metric_name("Memory Usage");
+    static const uint32_t disk_usage_name = metric_name("Disk Usage (/)");
+    static const uint32_t share_names[CpuLoadEngine::kShares] = {
+        metric_name("user"), metric_name("system"), metric_name("iowait"), metric_name("irq"),
+        metric_name("softirq"), metric_name("steal"), metric_name("busy")};
+
+    if (!cpu_load.update(stat_path)) return out.message("Error: cannot open /proc/stat");
+    out.number(cpu_usage_name, cpu_load.share(CpuLoadEngine::ShareBusy, 0), Unit::Percent, kFieldHistory);
+    for (int share = CpuLoadEngine::ShareUser; share < CpuLoadEngine::ShareBusy; ++share) {
+        out.number(share_names[share], cpu_load.share(static_cast<CpuLoadEngine::Share>(share), 0), Unit::Percent,
+                   share == CpuLoadEngine::ShareUser || share == CpuLoadEngine::ShareIrq ? 0 : kFieldInline, 17);
+    }
+    out.separator();
+
+    // Тепловая карта: одна ячейка на процессор, 32 ячейки в строке
+    const size_t cores = cpu_load.rows() - 1;
+    out.heading("Per-core busy [_.:-=+*#%@ = 0..100%]:");
+    char label[32];
+    for (size_t core = 0; core < cores; ++core) {
+        if (core % kHeatRow == 0) {
+            size_t last = std::min(core + kHeatRow, cores) - 1;
+            snprintf(label, sizeof(label), "cpu%d-%d", cpu_load.cpu_id(core + 1), cpu_load.cpu_id(last + 1));
+            out.text(0, label, 0, 12);
+        }
+        out.number(0, cpu_load.share(CpuLoadEngine::ShareBusy, core + 1), Unit::Percent, kFieldInline | kFieldHeat);
+    }
+    out.separator();
+
+    // Разбивка по каждому процессору
+    ensure_core_labels(cores);
+    for (size_t core = 0; core < cores; ++core) {
+        out.text(0, core_labels[core], kFieldRowKey, 6);
+        out.number(share_names[CpuLoadEngine::ShareBusy], cpu_load.share(CpuLoadEngine::ShareBusy, core + 1),
+                   Unit::Percent, kFieldInline, 14);
+        for (int share = CpuLoadEngine::ShareUser; share < CpuLoadEngine::ShareBusy; ++share) {
+            out.number(share_names[share], cpu_load.share(static_cast<CpuLoadEngine::Share>(share), core + 1),
+                       Unit::Percent, kFieldInline, 16);
+        }
+    }
+    out.separator();
+
+    if (!meminfo.update()) return out.message("Error: cannot read /proc/meminfo");
+    double mem_total = meminfo.bytes(MeminfoReader::MemTotal);
+    double mem_usage = (mem_total - meminfo.bytes(MeminfoReader::MemAvailable)) * 100.0 / mem_total;
+    out.number(mem_usage_name, mem_usage, Unit::Percent, kFieldHistory);
+    out.separator();
+
+    struct statvfs stat;
+    if (statvfs(root_path.c_str(), &stat) == 0) {
+        double disk_total = stat.f_blocks * stat.f_frsize;
+        double disk_free = stat.f_bfree * stat.f_frsize;
+        double disk_usage = (disk_total - disk_free) * 100.0 / disk_total;
+        out.number(disk_usage_name, disk_usage, Unit::Percent, kFieldHistory);
+    } else {
+        out.text(disk_usage_name, "Error");
+    }
+    out.separator();
+}
+
+void SystemUsageProvider::ensure_core_labels(size_t cores) {
+    if (core_labels.size() > cores) core_labels.resize(cores);
+    while (core_labels.size() < cores) {
+        core_labels.push_back("cpu" + std::to_string(cpu_load.cpu_id(core_labels.size() + 1)));
+    }
+}
+
+void TemperaturesProvider::sample(Snapshot& out) {
+    if (!discovered) {
+        discover();
+        discovered = true;
+    }
+    if (sensors.empty()) {
+        out.message("No temperature data found");
+        out.message("No hwmon or thermal sensors in " + root + "/sys/class");
+        return;
+    }
+
+    static const uint32_t max_name = metric_name("max");
+    static const uint32_t crit_name = metric_name("crit");
+    const std::string* chip = nullptr;
+    for (Sensor& sensor : sensors) {
+        char buf[32];
+        bool valid = sensor.input.read(buf, sizeof(buf)) > 0;
+        if (!chip || *chip != sensor.chip) {
+            if (chip) out.separator();
+            out.heading(sensor.chip);
+            chip = &sensor.chip;
+        }
+        if (valid) out.number(sensor.name, strtoll(buf, nullptr, 10), sensor.unit, kFieldHistory);
+        else out.text(sensor.name, "N/A");
+        if (sensor.max > 0) out.number(max_name, sensor.max, sensor.unit, kFieldInline);
+        if (sensor.crit > 0) out.number(crit_name, sensor.crit, sensor.unit, kFieldInline);
+    }
+}
+
+int64_t TemperaturesProvider::read_threshold(const std::string& path) {
+    std::string text = read_text_file(path);
+    return text.empty() ? 0 : strtoll(text.c_str(), nullptr, 10);
+}
+
+std::vector<std::string> TemperaturesProvider::list_dirs(const std::string& dir, const std::string& prefix) {
+    std::vector<std::pair<long, std::string>> found;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        found.emplace_back(strtol(name.c_str() + prefix.size(), nullptr, 10), entry.path().string());
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> dirs;
+    for (auto& item : found) dirs.push_back(std::move(item.second));
+    return dirs;
+}
+
+void TemperaturesProvider::discover() {
+    for (const std::string& dir : list_dirs(root + "/sys/class/hwmon", "hwmon")) {
+        discover_hwmon(dir);
+    }
+    for (const std::string& dir : list_dirs(root + "/sys/class/thermal", "thermal_zone")) {
+        discover_thermal_zone(dir);
+    }
+}
+
+void TemperaturesProvider::discover_hwmon(const std::string& dir) {
+    std::string chip = read_text_file(dir + "/name");
+    if (chip.empty()) chip = "hwmon";
+    chip += " (" + std::filesystem::path(dir).filename().string() + ")";
+
+    struct Channel {
+        Unit unit;
+        std::string prefix;
+        std::string input;
+    };
+    std::vector<std::pair<int, Channel>> channels;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        Unit unit;
+        size_t type_len;
+        if (name.compare(0, 4, "temp") == 0) { unit = Unit::MilliCelsius; type_len = 4; }
+        else if (name.compare(0, 3, "fan") == 0) { unit = Unit::Rpm; type_len = 3; }
+        else if (name.compare(0, 5, "power") == 0) { unit = Unit::MicroWatts; type_len = 5; }
+        else continue;
+        size_t underscore = name.find('_');
+        if (underscore == std::string::npos) continue;
+        std::string suffix = name.substr(underscore + 1);
+        // Для мощности драйверы отдают либо power_input, либо power_average
+        if (suffix != "input" && !(unit == Unit::MicroWatts && suffix == "average")) continue;
+        std::string prefix = name.substr(0, underscore);
+        if (std::any_of(channels.begin(), channels.end(), [&](const auto& c) { return c.second.prefix == prefix; })) continue;
+        int index = atoi(name.c_str() + type_len);
+        channels.push_back({static_cast<int>(unit) * 1000 + index, {unit, prefix, name}});
+    }
+    std::sort(channels.begin(), channels.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (auto& item : channels) {
+        Channel& channel = item.second;
+        Sensor sensor;
+        sensor.unit = channel.unit;
+        sensor.chip = chip;
+        std::string label = read_text_file(dir + "/" + channel.prefix + "_label");
+        sensor.name = metric_name(label.empty() ? channel.prefix : label);
+        if (!sensor.input.open(dir + "/" + channel.input)) continue;
+        sensor.max = read_threshold(dir + "/" + channel.prefix + "_max");
+        sensor.crit = read_threshold(dir + "/" + channel.prefix + "_crit");
+        sensors.push_back(std::move(sensor));
+    }
+}
+
+void TemperaturesProvider::discover_thermal_zone(const std::string& dir) {
+    Sensor sensor;
+    sensor.unit = Unit::MilliCelsius;
+    sensor.chip = "thermal (" + std::filesystem::path(dir).filename().string() + ")";
+    std::string label = read_text_file(dir + "/type");
+    sensor.name = metric_name(label.empty() ? "temp" : label);
+    if (!sensor.input.open(dir + "/temp")) return;
+    for (int trip = 0;; ++trip) {
+        const std::string prefix = dir + "/trip_point_" + std::to_string(trip) + "_";
+        std::string type = read_text_file(prefix + "type");
+        if (type.empty()) break;
+        if (type == "critical") sensor.crit = read_threshold(prefix + "temp");
+        else if (type == "hot") sensor.max = read_threshold(prefix + "temp");
+    }
+    sensors.push_back(std::move(sensor));
+}
+
+void MotherboardProvider::sample(Snapshot& out) {
+    // Данные платы не меняются до перезагрузки; запись root выдаётся только root
+    if (InventoryCache::instance().get(kCacheKey, out)) return;
+    if (getuid() != 0) {
+        out.message("Warning: dmidecode requires root privileges");
+        out.message("Run with sudo for full info");
+        return;
+    }
+    std::string output = exec_command("dmidecode -t baseboard 2>/dev/null");
+    if (output.find("Error") != std::string::npos) {
+        out.message("Error: dmidecode utility not found");
+        out.message("Please install dmidecode package");
+        out.message("Try: sudo dnf install dmidecode");
+        return;
+    }
+    std::istringstream iss(output);
+    std::string line;
+    while (std::getline(iss, line)) {
+        append_key_value_line(out, line);
+    }
+    if (out.empty()) out.message("No motherboard data found");
+    else InventoryCache::instance().put(kCacheKey, "dmi", out);
+}
+
+void MemoryProvider::sample(Snapshot& out) {
+    if (InventoryCache::instance().get(kCacheKey, out)) return;
+    if (getuid() != 0) {
+        out.message("Warning: dmidecode requires root privileges");
+        out.message("Run with sudo for full info");
+        return;
+    }
+    if (!is_utility_installed("dmidecode")) {
+        out.message("Error: dmidecode utility not found");
+        out.message("Please install dmidecode package");
+        return;
+    }
+    std::string output = exec_command("dmidecode -t memory 2>/dev/null");
+    std::istringstream iss(output);
+    std::string line;
+    bool in_memory_device = false;
+    while (std::getline(iss, line)) {
+        if (line.find("Memory Device") != std::string::npos) {
+            if (in_memory_device) {
+                out.separator();
+            }
+            in_memory_device = true;
+            continue;
+        }
+        if (in_memory_device && (line.find("Size:") != std::string::npos ||
+                                 line.find("Type:") != std::string::npos ||
+                                 line.find("Speed:") != std::string::npos ||
+                                 line.find("Manufacturer:") != std::string::npos ||
+                                 line.find("Part Number:") != std::string::npos)) {
+            append_key_value_line(out, line);
+        }
+    }
+    if (out.empty()) out.message("No memory data found");
+    else InventoryCache::instance().put(kCacheKey, "memory", out);
+}
+
+PressureProvider::PressureProvider(const std::string& root) : root(root), meminfo(root) {
+    static const char* const resources[] = {"cpu", "memory", "io"};
+    for (size_t i = 0; i < std::size(psi); ++i) {
+        psi[i].name = resources[i];
+        psi[i].file.open(root + "/proc/pressure/" + resources[i]);
+    }
+    vmstat.open(root + "/proc/vmstat");
+}
+
+void PressureProvider::sample(Snapshot& out) {
+    static const uint32_t avg10_name = metric_name("avg10");
+    static const uint32_t avg60_name = metric_name("avg60");
+    static const uint32_t avg300_name = metric_name("avg300");
+    static const uint32_t stall_name = metric_name("Stall");
+    static const uint32_t total_name = metric_name("Total");
+    static const uint32_t used_name = metric_name("Used");
+    static const uint32_t free_name = metric_name("Free");
+    static const uint32_t file_name = metric_name("File");
+    static const uint32_t anon_name = metric_name("Anon");
+    static const uint32_t miss_name = metric_name("NUMA misses");
+    static const uint32_t reserved_name = metric_name("Reserved");
+    static const uint32_t surplus_name = metric_name("Surplus");
+    static const uint32_t page_size_name = metric_name("Page Size");
+    static const uint32_t thp_name = metric_name("Transparent (anon)");
+    static const uint32_t shmem_thp_name = metric_name("Transparent (shmem)");
+    static const uint32_t slab_name = metric_name("Slab");
+    static const uint32_t reclaimable_name = metric_name("Reclaimable");
+    static const uint32_t unreclaimable_name = metric_name("Unreclaimable");
+    static const uint32_t stack_name = metric_name("Kernel Stack");
+    static const uint32_t page_tables_name = metric_name("Page Tables");
+    static const uint32_t oom_name = metric_name("OOM kills");
+    static const uint32_t event_names[] = {metric_name("Page faults"), metric_name("Major faults"), metric_name("Swap in"),
+                                           metric_name("Swap out"), metric_name("Compaction stalls"),
+                                           metric_name("Reclaim stalls")};
+
+    if (!nodes_valid.exchange(true)) discover_nodes();
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = previous_time.time_since_epoch().count() ? std::chrono::duration<double>(now - previous_time).count() : 0.0;
+    previous_time = now;
+    char line[128];
+
+    // PSI: доля времени, когда задачи ждали ресурс; "сейчас" — по приросту total за интервал
+    out.heading("Pressure stall information:");
+    snprintf(line, sizeof(line), "%-12s   %-8s   %-8s   %-8s   %s", "RESOURCE", "AVG10", "AVG60", "AVG300", "NOW");
+    out.heading(line);
+    bool has_psi = false;
+    for (Psi& resource : psi) {
+        std::string_view text = resource.file.read(), row;
+        while (next_line(text, row)) {
+            bool full = row.compare(0, 5, "full ") == 0;
+            if (!full && row.compare(0, 5, "some ") != 0) continue;
+            double avg[3] = {};
+            uint64_t total = 0;
+            if (!parse_psi_line(row, avg, total)) continue;
+            has_psi = true;
+            uint64_t& previous = full ? resource.full_total : resource.some_total;
+            snprintf(line, sizeof(line), "%s %s", resource.name, full ? "full" : "some");
+            out.text(0, line, kFieldRowKey, 12);
+            out.number(avg10_name, avg[0], Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+            out.number(avg60_name, avg[1], Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+            out.number(avg300_name, avg[2], Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+            double stall = previous && elapsed > 0 ? (total - previous) / (elapsed * 1e4) : 0.0; // мкс за секунду -> %
+            out.number(stall_name, std::clamp(stall, 0.0, 100.0), Unit::Percent, kFieldInline | kFieldNoLabel);
+            previous = total;
+        }
+    }
+    if (!has_psi) out.message("PSI is unavailable: kernel built without CONFIG_PSI or booted with psi=0");
+    out.separator();
+
+    // События памяти из /proc/vmstat в секунду
+    uint64_t events[kEvents] = {};
+    uint64_t oom_kills = 0;
+    read_vmstat(events, oom_kills);
+    out.heading("Memory events:");
+    if (elapsed <= 0) out.message("Collecting statistics...");
+    for (size_t i = 0; i < kEvents; ++i) {
+        double rate = elapsed > 0 && events[i] >= previous_events[i] ? (events[i] - previous_events[i]) / elapsed : 0.0;
+        if (elapsed > 0) out.number(event_names[i], rate, Unit::PerSecond, i % 2 ? kFieldInline : 0);
+        previous_events[i] = events[i];
+    }
+    out.number(oom_name, oom_kills, Unit::Count);
+    out.separator();
+
+    // Узлы NUMA: заполненность и промахи размещения
+    if (!nodes.empty()) {
+        out.heading("NUMA nodes:");
+        snprintf(line, sizeof(line), "%-6s   %-10s   %-10s   %-10s   %-10s   %-10s   %s", "NODE", "TOTAL", "USED", "FREE", "FILE",
+                 "ANON", "MISSES");
+        out.heading(line);
+        for (Node& node : nodes) {
+            uint64_t values[kNodeKeys] = {};
+            if (!read_node_meminfo(node, values)) continue;
+            uint64_t misses = read_numa_miss(node);
+            double miss_rate = elapsed > 0 && node.previous_misses && misses >= node.previous_misses
+                                   ? (misses - node.previous_misses) / elapsed
+                                   : 0.0;
+            node.previous_misses = misses;
+            out.text(0, node.name, kFieldRowKey, 6);
+            out.number(total_name, values[NodeTotal] * 1024.0, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+            out.number(used_name, (values[NodeTotal] - values[NodeFree]) * 1024.0, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+            out.number(free_name, values[NodeFree] * 1024.0, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+            out.number(file_name, values[NodeFile] * 1024.0, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+            out.number(anon_name, values[NodeAnon] * 1024.0, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+            out.number(miss_name, miss_rate, Unit::PerSecond, kFieldInline | kFieldNoLabel);
+        }
+        out.separator();
+    }
+
+    if (!meminfo.update()) return out.message("Error: cannot read /proc/meminfo");
+    out.heading("Huge pages:");
+    out.number(total_name, meminfo.count(MeminfoReader::HugePagesTotal), Unit::Count);
+    out.number(free_name, meminfo.count(MeminfoReader::HugePagesFree), Unit::Count, kFieldInline);
+    out.number(reserved_name, meminfo.count(MeminfoReader::HugePagesRsvd), Unit::Count, kFieldInline);
+    out.number(surplus_name, meminfo.count(MeminfoReader::HugePagesSurp), Unit::Count, kFieldInline);
+    out.number(page_size_name, meminfo.bytes(MeminfoReader::Hugepagesize), Unit::Bytes, kFieldInline);
+    out.number(thp_name, meminfo.bytes(MeminfoReader::AnonHugePages), Unit::Bytes);
+    out.number(shmem_thp_name, meminfo.bytes(MeminfoReader::ShmemHugePages), Unit::Bytes, kFieldInline);
+    out.separator();
+    out.heading("Kernel memory:");
+    out.number(slab_name, meminfo.bytes(MeminfoReader::Slab), Unit::Bytes);
+    out.number(reclaimable_name, meminfo.bytes(MeminfoReader::SReclaimable), Unit::Bytes, kFieldInline);
+    out.number(unreclaimable_name, meminfo.bytes(MeminfoReader::SUnreclaim), Unit::Bytes, kFieldInline);
+    out.number(stack_name, meminfo.bytes(MeminfoReader::KernelStack), Unit::Bytes);
+    out.number(page_tables_name, meminfo.bytes(MeminfoReader::PageTables), Unit::Bytes, kFieldInline);
+}
+
+void PressureProvider::discover_nodes() {
+    nodes.clear();
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(root + "/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, 4, "node") == 0 && name.size() > 4 && isdigit(static_cast<unsigned char>(name[4]))) names.push_back(name);
+    }
+    std::sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    for (const std::string& name : names) {
+        Node& node = nodes.emplace_back();
+        node.name = name;
+        const std::string base = root + "/sys/devices/system/node/" + name;
+        node.meminfo.open(base + "/meminfo");
+        node.numastat.open(base + "/numastat");
+    }
+}
+
+bool PressureProvider::parse_psi_line(std::string_view line, double avg[3], uint64_t& total) {
+    static constexpr std::string_view keys[] = {"avg10=", "avg60=", "avg300=", "total="};
+    for (size_t i = 0; i < std::size(keys); ++i) {
+        size_t pos = line.find(keys[i]);
+        if (pos == std::string_view::npos) return false;
+        const char* begin = line.data() + pos + keys[i].size();
+        const char* end = line.data() + line.size();
+        bool ok = i < 3 ? std::from_chars(begin, end, avg[i]).ec == std::errc() : std::from_chars(begin, end, total).ec == std::errc();
+        if (!ok) return false;
+    }
+    return true;
+}
+
+void PressureProvider::read_vmstat(uint64_t events[kEvents], uint64_t& oom_kills) {
+    static constexpr std::string_view keys[] = {"pgfault", "pgmajfault", "pswpin", "pswpout", "compact_stall"};
+    std::string_view text = vmstat.read(), line;
+    while (next_line(text, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string_view::npos) continue;
+        std::string_view key = line.substr(0, space);
+        const char* p = line.data() + space;
+        uint64_t value = 0;
+        if (!parse_u64(p, line.data() + line.size(), value)) continue;
+        if (key.compare(0, 10, "allocstall") == 0) {
+            events[ReclaimStalls] += value;
+        } else if (key == "oom_kill") {
+            oom_kills = value;
+        } else {
+            for (size_t i = 0; i < std::size(keys); ++i) {
+                if (key == keys[i]) events[i] = value;
+            }
+        }
+    }
+}
+
+bool PressureProvider::read_node_meminfo(Node& node, uint64_t values[kNodeKeys]) {
+    static constexpr std::string_view keys[] = {"MemTotal", "MemFree", "FilePages", "AnonPages"};
+    std::string_view text = node.meminfo.read(), line;
+    if (text.empty()) return false;
+    while (next_line(text, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view key = line.substr(0, colon);
+        key.remove_prefix(std::min(key.rfind(' ') + 1, key.size()));
+        for (size_t i = 0; i < std::size(keys); ++i) {
+            if (key != keys[i]) continue;
+            const char* p = line.data() + colon + 1;
+            parse_u64(p, line.data() + line.size(), values[i]);
+        }
+    }
+    return values[NodeTotal] > 0;
+}
+
+uint64_t PressureProvider::read_numa_miss(Node& node) {
+    std::string_view text = node.numastat.read(), line;
+    while (next_line(text, line)) {
+        if (line.compare(0, 10, "numa_miss ") != 0) continue;
+        const char* p = line.data() + 9;
+        uint64_t value = 0;
+        parse_u64(p, line.data() + line.size(), value);
+        return value;
+    }
+    return 0;
+}
+
+void DisksProvider::sample(Snapshot& out) {
+    static const uint32_t size_name = metric_name("Size");
+    static const uint32_t partitions_name = metric_name("Partitions");
+    static const uint32_t model_name = metric_name("Model");
+    static const uint32_t mapper_name = metric_name("Mapper");
+    static const uint32_t reads_name = metric_name("Reads");
+    static const uint32_t writes_name = metric_name("Writes");
+    static const uint32_t read_name = metric_name("Read");
+    static const uint32_t write_name = metric_name("Write");
+    static const uint32_t latency_name = metric_name("Latency");
+    static const uint32_t queue_name = metric_name("Queue");
+    static const uint32_t util_name = metric_name("Util");
+
+    if (!diskstats.is_open() && !diskstats.open(root + "/proc/diskstats")) {
+        return out.message("Error: cannot open /proc/diskstats");
+    }
+    if (!topology_valid.exchange(true)) discover();
+    if (devices.empty()) return out.message("No block devices found in " + root + "/sys/block");
+    double elapsed = read_counters();
+
+    out.heading("Devices:");
+    for (const Device& device : devices) {
+        out.text(0, device.name, kFieldRowKey, 12);
+        out.number(size_name, device.size, Unit::Bytes, kFieldInline, 18);
+        out.number(partitions_name, device.partitions, Unit::Count, kFieldInline, 16);
+        if (!device.label.empty()) out.text(device.mapper ? mapper_name : model_name, device.label, kFieldInline);
+    }
+    out.separator();
+
+    out.heading("I/O:");
+    if (elapsed <= 0) out.message("Collecting statistics...");
+    for (Device& device : devices) {
+        if (elapsed > 0 && device.sampled) {
+            uint64_t delta[kCounters];
+            for (int i = 0; i < kCounters; ++i) delta[i] = device.current[i] - device.previous[i];
+            uint64_t ios = delta[Reads] + delta[Writes];
+            double latency = ios ? static_cast<double>(delta[ReadTicks] + delta[WriteTicks]) / ios : 0.0;
+            double queue = delta[QueueTicks] / (elapsed * 1000.0);
+            out.text(0, device.name, kFieldRowKey, 12);
+            out.number(reads_name, delta[Reads] / elapsed, Unit::PerSecond, kFieldInline, 16);
+            out.number(writes_name, delta[Writes] / elapsed, Unit::PerSecond, kFieldInline, 16);
+            out.number(read_name, delta[SectorsRead] * 512.0 / elapsed, Unit::BytesPerSecond, kFieldInline, 18);
+            out.number(write_name, delta[SectorsWritten] * 512.0 / elapsed, Unit::BytesPerSecond, kFieldInline, 19);
+            out.number(latency_name, latency, Unit::Milliseconds, kFieldInline, 18);
+            out.number(queue_name, std::round(queue * 100.0) / 100.0, Unit::None, kFieldInline, 12);
+            out.number(util_name, std::min(100.0, delta[IoTicks] / (elapsed * 10.0)), Unit::Percent, kFieldInline);
+        }
+        std::copy(std::begin(device.current), std::end(device.current), device.previous);
+        device.sampled = device.present;
+    }
+    out.separator();
+
+    sample_mounts(out);
+}
+
+bool DisksProvider::parse_device_number(const std::string& text, uint64_t& number) {
+    char* end;
+    unsigned long major = strtoul(text.c_str(), &end, 10);
+    if (*end != ':') return false;
+    number = device_number(major, strtoul(end + 1, nullptr, 10));
+    return true;
+}
+
+void DisksProvider::discover() {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(root + "/sys/block", ec)) {
+        std::string name = entry.path().filename().string();
+        // loop и ram не несут дисковой нагрузки и на хостах со snap исчисляются десятками
+        if (name.compare(0, 4, "loop") == 0 || name.compare(0, 3, "ram") == 0) continue;
+        names.push_back(std::move(name));
+    }
+    std::sort(names.begin(), names.end());
+
+    devices.clear();
+    numbers.clear();
+    for (const std::string& name : names) {
+        std::string dir = root + "/sys/block/" + name;
+        uint64_t number;
+        if (!parse_device_number(read_text_file(dir + "/dev"), number)) continue;
+        Device device;
+        device.name = name;
+        device.size = strtod(read_text_file(dir + "/size").c_str(), nullptr) * 512.0;
+        if (device.size == 0) continue;
+        device.label = read_text_file(dir + "/dm/name");
+        device.mapper = !device.label.empty();
+        if (!device.mapper) device.label = read_text_file(dir + "/device/model");
+        numbers[number] = {devices.size(), false, name};
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            uint64_t part_number;
+            if (!std::filesystem::exists(entry.path() / "partition", ec)) continue;
+            if (!parse_device_number(read_text_file((entry.path() / "dev").string()), part_number)) continue;
+            numbers[part_number] = {devices.size(), true, entry.path().filename().string()};
+            ++device.partitions;
+        }
+        devices.push_back(std::move(device));
+    }
+    has_previous = false;
+    mounts.clear(); // подписи точек монтирования зависят от разделов
+}
+
+double DisksProvider::read_counters() {
+    if (diskstats.read(buffer) < 0) return 0;
+    auto now = std::chrono::steady_clock::now();
+    for (Device& device : devices) device.present = false;
+
+    size_t lines = 0;
+    std::string_view text(buffer.data()), line;
+    while (next_line(text, line)) {
+        const char* p = line.data();
+        const char* end = p + line.size();
+        uint64_t major = 0, minor = 0;
+        parse_u64(p, end, major);
+        parse_u64(p, end, minor);
+        while (p < end && *p == ' ') ++p;
+        const char* name = p;
+        while (p < end && *p != ' ') ++p;
+        std::string_view device_name(name, p - name);
+        // reads merged sectors ms writes merged sectors ms in_flight io_ticks time_in_queue
+        uint64_t values[11] = {};
+        for (uint64_t& value : values) {
+            if (!parse_u64(p, end, value)) break;
+        }
+        ++lines;
+
+        auto it = numbers.find(device_number(major, minor));
+        if (it == numbers.end() || it->second.partition || it->second.name != device_name) continue;
+        Device& device = devices[it->second.device];
+        device.current[Reads] = values[0];
+        device.current[SectorsRead] = values[2];
+        device.current[ReadTicks] = values[3];
+        device.current[Writes] = values[4];
+        device.current[SectorsWritten] = values[6];
+        device.current[WriteTicks] = values[7];
+        device.current[IoTicks] = values[9];
+        device.current[QueueTicks] = values[10];
+        device.present = true;
+    }
+    // Число строк меняется при подключении дисков; uevent может быть недоступен
+    if (diskstats_lines != 0 && lines != diskstats_lines) topology_valid = false;
+    diskstats_lines = lines;
+
+    double elapsed = std::chrono::duration<double>(now - last_read).count();
+    last_read = now;
+    bool ready = has_previous;
+    has_previous = true;
+    return ready ? elapsed : 0;
+}
+
+void DisksProvider::update_mounts() {
+    if (!mountinfo.is_open()) {
+        if (!mountinfo.open(root + "/proc/self/mountinfo")) return;
+        mounts.clear();
+    }
+    if (!mounts.empty() && !mountinfo.poll_changed()) return;
+    mounts.clear();
+    if (mountinfo.read(buffer) < 0) return;
+
+    std::vector<uint64_t> seen;
+    std::string_view text(buffer.data());
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+
+        // id parent major:minor root mount_point options [optional...] - fstype source super_options
+        std::string_view fields[5];
+        size_t pos = 0;
+        for (std::string_view& field : fields) {
+            size_t space = line.find(' ', pos);
+            if (space == std::string_view::npos) break;
+            field = line.substr(pos, space - pos);
+            pos = space + 1;
+        }
+        size_t dash = line.find(" - ", pos);
+        if (fields[4].empty() || dash == std::string_view::npos) continue;
+        std::string_view tail = line.substr(dash + 3);
+        size_t source_start = tail.find(' ');
+        if (source_start == std::string_view::npos) continue;
+        std::string_view source = tail.substr(source_start + 1);
+        source = source.substr(0, source.find(' '));
+
+        uint64_t number;
+        if (!parse_device_number(std::string(fields[2]), number)) continue;
+        // Реальные файловые системы: блочное устройство или источник в /dev (btrfs имеет major 0)
+        if ((number >> 32) == 0 && source.compare(0, 5, "/dev/") != 0) continue;
+        // Bind-монтирования того же устройства не повторяем
+        if (std::find(seen.begin(), seen.end(), number) != seen.end()) continue;
+        seen.push_back(number);
+
+        Mount mount;
+        mount.point = unescape(fields[4]);
+        auto it = numbers.find(number);
+        if (it != numbers.end()) mount.source = it->second.name;
+        else mount.source = std::string(source.substr(source.rfind('/') + 1));
+        mounts.push_back(std::move(mount));
+    }
+}
+
+std::string DisksProvider::unescape(std::string_view text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 3 < text.size() && isdigit(text[i + 1])) {
+            result += static_cast<char>(((text[i + 1] - '0') << 6) | ((text[i + 2] - '0') << 3) | (text[i + 3] - '0'));
+            i += 3;
+        } else {
+            result += text[i];
+        }
+    }
+    return result;
+}
+
+void DisksProvider::sample_mounts(Snapshot& out) {
+    static const uint32_t device_name = metric_name("Device");
+    static const uint32_t size_name = metric_name("Size");
+    static const uint32_t used_name = metric_name("Used");
+    static const uint32_t inodes_name = metric_name("Inodes");
+
+    update_mounts();
+    out.heading("Mounts:");
+    if (mounts.empty()) return out.message("No mounted block devices found");
+    for (const Mount& mount : mounts) {
+        out.text(0, mount.point, kFieldRowKey, 20);
+        out.text(device_name, mount.source, kFieldInline, 22);
+        struct statvfs stat;
+        if (statvfs((root + mount.point).c_str(), &stat) != 0) {
+            out.text(size_name, "N/A", kFieldInline);
+            continue;
+        }
+        // Как в df: занятое место относительно доступного непривилегированному пользователю
+        double used = static_cast<double>(stat.f_blocks - stat.f_bfree) * stat.f_frsize;
+        double available = static_cast<double>(stat.f_bavail) * stat.f_frsize;
+        out.number(size_name, static_cast<double>(stat.f_blocks) * stat.f_frsize, Unit::Bytes, kFieldInline, 18);
+        out.number(used_name, used + available > 0 ? used * 100.0 / (used + available) : 0.0, Unit::Percent, kFieldInline, 14);
+        if (stat.f_files > 0) {
+            out.number(inodes_name, (stat.f_files - stat.f_ffree) * 100.0 / stat.f_files, Unit::Percent, kFieldInline);
+        }
+    }
+}
+
+bool InterfaceFilter::matches(const char* name) const {
+    for (const std::string& pattern : exclude) {
+        if (fnmatch(pattern.c_str(), name, 0) == 0) return false;
+    }
+    if (include.empty()) return true;
+    for (const std::string& pattern : include) {
+        if (fnmatch(pattern.c_str(), name, 0) == 0) return true;
+    }
+    return false;
+}
+
+NetworkProvider::~NetworkProvider() {
+    if (fd >= 0) close(fd);
+}
+
+void NetworkProvider::sample(Snapshot& out) {
+    static const uint32_t state_name = metric_name("State");
+    static const uint32_t rx_name = metric_name("RX");
+    static const uint32_t tx_name = metric_name("TX");
+    static const uint32_t rx_packets_name = metric_name("RX packets");
+    static const uint32_t tx_packets_name = metric_name("TX packets");
+    static const uint32_t errors_name = metric_name("Errors");
+    static const uint32_t drops_name = metric_name("Drops");
+    static const uint32_t bluetooth_name = metric_name("Bluetooth");
+    static const char* const oper_states[] = {"UNKNOWN", "NOTPRESENT", "DOWN", "LOWERLAYERDOWN", "TESTING", "DORMANT", "UP"};
+
+    double elapsed = 0;
+    if (!dump_links(elapsed)) {
+        out.message(std::string("Error: rtnetlink link dump failed: ") + strerror(errno));
+    } else if (interfaces.empty()) {
+        out.message("No network interfaces match the filter");
+    } else {
+        if (elapsed <= 0) out.message("Collecting statistics...");
+        for (Interface& iface : interfaces) {
+            out.text(0, iface.name, kFieldRowKey, 16);
+            out.text(state_name, iface.oper_state < 7 ? oper_states[iface.oper_state] : "UNKNOWN", kFieldInline, 22);
+            if (elapsed > 0 && iface.sampled) {
+                double delta[kCounters];
+                // Счётчики сбрасываются при перезагрузке драйвера и пересоздании интерфейса
+                for (int i = 0; i < kCounters; ++i) delta[i] = counter_rate(iface.previous[i], iface.current[i], elapsed);
+                out.number(rx_name, delta[RxBytes], Unit::BytesPerSecond, kFieldInline, 18);
+                out.number(tx_name, delta[TxBytes], Unit::BytesPerSecond, kFieldInline, 18);
+                out.number(rx_packets_name, delta[RxPackets], Unit::PerSecond, kFieldInline, 22);
+                out.number(tx_packets_name, delta[TxPackets], Unit::PerSecond, kFieldInline, 22);
+                out.number(errors_name, delta[RxErrors] + delta[TxErrors], Unit::PerSecond, kFieldInline, 16);
+                out.number(drops_name, delta[RxDropped] + delta[TxDropped], Unit::PerSecond, kFieldInline);
+            }
+            std::copy(std::begin(iface.current), std::end(iface.current), iface.previous);
+            iface.sampled = true;
+        }
+    }
+    out.separator();
+    out.text(bluetooth_name, bluetooth_state());
+}
+
+bool NetworkProvider::open_socket() {
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return false;
+    // Ядро отвечает сразу; таймаут страхует от зависания потока опроса
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    buffer.resize(64 * 1024); // рекомендуемый размер для дампов netlink
+    return true;
+}
+
+bool NetworkProvider::dump_links(double& elapsed) {
+    if (fd < 0 && !open_socket()) return false;
+    struct {
+        nlmsghdr header;
+        ifinfomsg info;
+    } request{};
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++sequence;
+    request.info.ifi_family = AF_UNSPEC;
+    if (send(fd, &request, sizeof(request), 0) < 0) return reset();
+
+    ++generation;
+    bool done = false;
+    while (!done) {
+        ssize_t length = recv(fd, buffer.data(), buffer.size(), 0);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            return reset();
+        }
+        for (auto* header = reinterpret_cast<nlmsghdr*>(buffer.data()); NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_seq != sequence) continue; // ответ на прерванный прошлый запрос
+            if (header->nlmsg_type == NLMSG_DONE) {
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                errno = -reinterpret_cast<nlmsgerr*>(NLMSG_DATA(header))->error;
+                return false;
+            }
+            if (header->nlmsg_type == RTM_NEWLINK) parse_link(header);
+        }
+    }
+
+    // Исчезнувшие интерфейсы удаляются, позиции остальных пересчитываются
+    size_t kept = 0;
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+        if (interfaces[i].generation != generation) continue;
+        if (kept != i) interfaces[kept] = std::move(interfaces[i]);
+        ++kept;
+    }
+    if (kept != interfaces.size()) {
+        interfaces.resize(kept);
+        slots.clear();
+        for (size_t i = 0; i < interfaces.size(); ++i) slots[interfaces[i].index] = i;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    elapsed = generation > 1 ? std::chrono::duration<double>(now - last_dump).count() : 0;
+    last_dump = now;
+    return true;
+}
+
+bool NetworkProvider::reset() {
+    int saved = errno;
+    close(fd);
+    fd = -1;
+    errno = saved;
+    return false;
+}
+
+void NetworkProvider::parse_link(nlmsghdr* header) {
+    auto* info = reinterpret_cast<ifinfomsg*>(NLMSG_DATA(header));
+    int length = IFLA_PAYLOAD(header);
+    const char* name = nullptr;
+    const rtattr* stats = nullptr;
+    uint8_t oper_state = 0;
+    for (auto* attr = IFLA_RTA(info); RTA_OK(attr, length); attr = RTA_NEXT(attr, length)) {
+        switch (attr->rta_type) {
+            case IFLA_IFNAME: name = static_cast<const char*>(RTA_DATA(attr)); break;
+            case IFLA_OPERSTATE: oper_state = *static_cast<const uint8_t*>(RTA_DATA(attr)); break;
+            case IFLA_STATS64: stats = attr; break;
+        }
+    }
+    if (!name || !filter.matches(name)) return;
+
+    auto slot = slots.find(info->ifi_index);
+    if (slot == slots.end()) {
+        slot = slots.emplace(info->ifi_index, interfaces.size()).first;
+        interfaces.emplace_back().index = info->ifi_index;
+    }
+    Interface& iface = interfaces[slot->second];
+    if (iface.name != name) iface.name = name; // переименование интерфейса
+    iface.oper_state = oper_state;
+    iface.generation = generation;
+    if (stats && RTA_PAYLOAD(stats) >= sizeof(rtnl_link_stats64)) {
+        rtnl_link_stats64 counters;
+        memcpy(&counters, RTA_DATA(stats), sizeof(counters)); // атрибут может быть не выровнен на 8
+        iface.current[RxBytes] = counters.rx_bytes;
+        iface.current[TxBytes] = counters.tx_bytes;
+        iface.current[RxPackets] = counters.rx_packets;
+        iface.current[TxPackets] = counters.tx_packets;
+        iface.current[RxErrors] = counters.rx_errors;
+        iface.current[TxErrors] = counters.tx_errors;
+        iface.current[RxDropped] = counters.rx_dropped;
+        iface.current[TxDropped] = counters.tx_dropped;
+    }
+}
+
+const char* NetworkProvider::bluetooth_state() const {
+    std::error_code ec;
+    if (std::filesystem::is_empty(root + "/sys/class/bluetooth", ec) || ec) return "Disabled or not found";
+    for (const auto& entry : std::filesystem::directory_iterator(root + "/sys/class/rfkill", ec)) {
+        std::string dir = entry.path().string();
+        if (read_text_file(dir + "/type") != "bluetooth") continue;
+        if (read_text_file(dir + "/soft") == "1" || read_text_file(dir + "/hard") == "1") return "Blocked";
+    }
+    return "Enabled";
+}
+
+void GPUProvider::sample(Snapshot& out) {
+    static const uint32_t model_name = metric_name("GPU Model");
+    static const uint32_t driver_name = metric_name("Driver");
+    static const uint32_t driver_version_name = metric_name("Driver Version");
+    static const uint32_t util_name = metric_name("GPU Utilization");
+    static const uint32_t vram_used_name = metric_name("VRAM Used");
+    static const uint32_t vram_total_name = metric_name("VRAM Total");
+    static const uint32_t sclk_name = metric_name("Shader Clock");
+    static const uint32_t mclk_name = metric_name("Memory Clock");
+    static const uint32_t max_clock_name = metric_name("Max Clock");
+    static const uint32_t temp_name = metric_name("Temperature");
+    static const uint32_t power_name = metric_name("Power");
+
+    if (!devices_valid.exchange(true)) discover();
+    bool has_nvidia = false;
+    for (const Gpu& gpu : gpus) has_nvidia |= gpu.vendor == kVendorNvidia;
+    if (has_nvidia) read_nvidia();
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < gpus.size(); ++i) {
+        Gpu& gpu = gpus[i];
+        if (i > 0) out.separator();
+        // Адрес PCI — заголовок карты: по нему различаются ряды одинаковых карт в /metrics
+        out.heading(gpu.slot);
+        out.text(model_name, gpu.model);
+        out.text(driver_name, gpu.driver.empty() ? std::string_view("none") : std::string_view(gpu.driver));
+
+        uint64_t value;
+        if (gpu.busy.read_u64(value)) out.number(util_name, value, Unit::Percent, kFieldHistory);
+        if (gpu.rc6.read_u64(value)) {
+            // У i915 нет счётчика загрузки в sysfs: занятость — доля времени вне RC6
+            double elapsed = std::chrono::duration<double, std::milli>(now - gpu.previous_time).count();
+            if (gpu.previous_rc6 && elapsed > 0) {
+                double idle = std::clamp((value - gpu.previous_rc6) / elapsed, 0.0, 1.0);
+                out.number(util_name, (1.0 - idle) * 100.0, Unit::Percent, kFieldHistory);
+            }
+            gpu.previous_rc6 = value;
+            gpu.previous_time = now;
+        }
+        if (gpu.vram_used.read_u64(value)) out.number(vram_used_name, value, Unit::Bytes);
+        if (gpu.vram_total.read_u64(value)) out.number(vram_total_name, value, Unit::Bytes, kFieldInline);
+        if (read_dpm_level(gpu.sclk, value) || gpu.cur_freq.read_u64(value)) out.number(sclk_name, value * 1000.0, Unit::KiloHertz);
+        if (read_dpm_level(gpu.mclk, value)) out.number(mclk_name, value * 1000.0, Unit::KiloHertz, kFieldInline);
+        if (gpu.max_freq.read_u64(value)) out.number(max_clock_name, value * 1000.0, Unit::KiloHertz, kFieldInline);
+        if (gpu.temp.read_u64(value)) out.number(temp_name, value, Unit::MilliCelsius);
+        if (gpu.power.read_u64(value)) out.number(power_name, value, Unit::MicroWatts, kFieldInline);
+
+        if (gpu.vendor != kVendorNvidia) continue;
+        const NvidiaSample* nvidia = find_nvidia(gpu.slot);
+        if (!nvidia) {
+            out.message(nvidia_status());
+            continue;
+        }
+        out.text(driver_version_name, nvidia->driver);
+        const double* v = nvidia->values;
+        if (!std::isnan(v[NvUtil])) out.number(util_name, v[NvUtil], Unit::Percent, kFieldHistory);
+        if (!std::isnan(v[NvMemUsed])) out.number(vram_used_name, v[NvMemUsed] * 1048576.0, Unit::Bytes);
+        if (!std::isnan(v[NvMemTotal])) out.number(vram_total_name, v[NvMemTotal] * 1048576.0, Unit::Bytes, kFieldInline);
+        if (!std::isnan(v[NvClock])) out.number(sclk_name, v[NvClock] * 1000.0, Unit::KiloHertz);
+        if (!std::isnan(v[NvTemp])) out.number(temp_name, v[NvTemp] * 1000.0, Unit::MilliCelsius);
+        if (!std::isnan(v[NvPower])) out.number(power_name, v[NvPower] * 1000000.0, Unit::MicroWatts, kFieldInline);
+    }
+    if (gpus.empty()) out.message("No GPU found in /sys/bus/pci");
+}
+
+void GPUProvider::discover() {
+    gpus.clear();
+    std::error_code ec;
+    const std::string devices = root + "/sys/bus/pci/devices";
+    std::vector<std::string> slots;
+    for (const auto& entry : std::filesystem::directory_iterator(devices, ec)) {
+        // Класс 0x03xxxx: VGA, 3D и прочие контроллеры дисплея
+        if (read_text_file(entry.path().string() + "/class").compare(0, 4, "0x03") == 0) {
+            slots.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(slots.begin(), slots.end());
+    for (const std::string& slot : slots) {
+        Gpu& gpu = gpus.emplace_back();
+        const std::string dev = devices + "/" + slot;
+        gpu.slot = slot;
+        gpu.vendor = static_cast<uint32_t>(strtoul(read_text_file(dev + "/vendor").c_str(), nullptr, 16));
+        uint32_t device = static_cast<uint32_t>(strtoul(read_text_file(dev + "/device").c_str(), nullptr, 16));
+        gpu.model = pci_device_name(gpu.vendor, device);
+        std::string uevent = read_text_file(dev + "/uevent");
+        size_t driver = uevent.find("DRIVER=");
+        if (driver != std::string::npos) gpu.driver = uevent.substr(driver + 7, uevent.find('\n', driver) - driver - 7);
+
+        if (gpu.vendor == kVendorAmd) {
+            gpu.busy.open(dev + "/gpu_busy_percent");
+            gpu.vram_used.open(dev + "/mem_info_vram_used");
+            gpu.vram_total.open(dev + "/mem_info_vram_total");
+            gpu.sclk.open(dev + "/pp_dpm_sclk");
+            gpu.mclk.open(dev + "/pp_dpm_mclk");
+        }
+        if (gpu.vendor == kVendorIntel) {
+            // Файлы i915 лежат в каталоге карты /sys/class/drm/cardN
+            for (const auto& card : std::filesystem::directory_iterator(dev + "/drm", ec)) {
+                std::string name = card.path().filename().string();
+                if (name.compare(0, 4, "card") != 0 || name.find('-') != std::string::npos) continue;
+                const std::string base = root + "/sys/class/drm/" + name;
+                gpu.cur_freq.open(base + "/gt_cur_freq_mhz");
+                gpu.max_freq.open(base + "/gt_max_freq_mhz");
+                gpu.rc6.open(base + "/power/rc6_residency_ms");
+                break;
+            }
+        }
+        for (const auto& hwmon : std::filesystem::directory_iterator(dev + "/hwmon", ec)) {
+            gpu.temp.open(hwmon.path().string() + "/temp1_input");
+            if (!gpu.power.open(hwmon.path().string() + "/power1_average")) gpu.power.open(hwmon.path().string() + "/power1_input");
+            break;
+        }
+    }
+    // Ручное обновление разрешает сразу перезапустить упавший nvidia-smi
+    nvidia_missing = false;
+    nvidia_restart = {};
+}
+
+bool GPUProvider::read_dpm_level(const PreadFile& file, uint64_t& mhz) {
+    char buf[512];
+    ssize_t count = file.read(buf, sizeof(buf));
+    if (count <= 0) return false;
+    std::string_view text(buf, count), line;
+    while (next_line(text, line)) {
+        if (line.find('*') == std::string_view::npos) continue;
+        size_t colon = line.find(':');
+        const char* p = line.data() + (colon == std::string_view::npos ? 0 : colon + 1);
+        return parse_u64(p, line.data() + line.size(), mhz);
+    }
+    return false;
+}
+
+void GPUProvider::read_nvidia() {
+    if (!nvidia_smi.running()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now < nvidia_restart) return;
+        nvidia_restart = now + kRestartDelay;
+        nvidia_missing = !is_utility_installed("nvidia-smi");
+        if (nvidia_missing) return;
+        char cmd[320];
+        snprintf(cmd, sizeof(cmd),
+                 "exec nvidia-smi --query-gpu=index,pci.bus_id,name,driver_version,memory.total,memory.used,"
+                 "utilization.gpu,temperature.gpu,clocks.sm,power.draw --format=csv,noheader,nounits --loop-ms=%lld",
+                 static_cast<long long>(refreshInterval().count()));
+        nvidia_smi.start(cmd);
+    }
+    nvidia_smi.read_lines([this](std::string_view line) { parse_nvidia_line(line); });
+}
+
+void GPUProvider::parse_nvidia_line(std::string_view line) {
+    std::string_view columns[4 + kNvidiaColumns];
+    size_t count = 0;
+    while (count < std::size(columns)) {
+        size_t comma = line.find(',');
+        std::string_view column = line.substr(0, comma);
+        while (!column.empty() && column.front() == ' ') column.remove_prefix(1);
+        while (!column.empty() && (column.back() == ' ' || column.back() == '\r')) column.remove_suffix(1);
+        columns[count++] = column;
+        if (comma == std::string_view::npos) break;
+        line.remove_prefix(comma + 1);
+    }
+    if (count != std::size(columns) || columns[1].size() < 7) return;
+    std::string bus(columns[1].substr(columns[1].size() - 7));
+    for (char& c : bus) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+
+    NvidiaSample* row = find_nvidia(bus);
+    if (!row) {
+        row = &nvidia_rows.emplace_back();
+        row->bus = bus;
+    }
+    row->name.assign(columns[2]);
+    row->driver.assign(columns[3]);
+    for (size_t i = 0; i < kNvidiaColumns; ++i) {
+        std::string_view text = columns[4 + i];
+        double value;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        row->values[i] = ec == std::errc() ? value : std::nan("");
+    }
+}
+
+GPUProvider::NvidiaSample* GPUProvider::find_nvidia(std::string_view slot) {
+    if (slot.size() < 7) return nullptr;
+    slot = slot.substr(slot.size() - 7);
+    for (NvidiaSample& row : nvidia_rows) {
+        if (row.bus == slot) return &row;
+    }
+    return nullptr;
+}
+
+const char* GPUProvider::nvidia_status() const {
+    if (nvidia_missing) return "NVIDIA: install the driver utilities (nvidia-smi) for utilization and memory";
+    return nvidia_smi.running() ? "NVIDIA: waiting for nvidia-smi..." : "NVIDIA: nvidia-smi exited, restarting";
+}
+
+RangeWorkers::~RangeWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void RangeWorkers::run(size_t count, size_t parts, const std::function<void(size_t, size_t)>& fn) {
+    parts = std::max<size_t>(1, std::min(parts, count));
+    const size_t step = (count + parts - 1) / parts;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (threads.size() + 1 < parts) {
+        threads.emplace_back(&RangeWorkers::loop, this, threads.size() + 1);
+    }
+    task = &fn;
+    task_count = count;
+    task_step = step;
+    active = parts;
+    pending = parts - 1;
+    ++round;
+    lock.unlock();
+    wake.notify_all();
+
+    fn(0, std::min(step, count));
+
+    lock.lock();
+    done.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+    SelfStats::thread_bytes_read += helper_bytes;
+    helper_bytes = 0;
+}
+
+void RangeWorkers::loop(size_t index) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || round != seen; });
+        if (stopping) return;
+        seen = round;
+        if (index >= active) continue; // в этом раунде частей меньше, чем помощников
+        const size_t begin = std::min(index * task_step, task_count);
+        const size_t end = std::min(begin + task_step, task_count);
+        const auto* fn = task;
+        lock.unlock();
+        const uint64_t before = SelfStats::thread_bytes_read;
+        (*fn)(begin, end);
+        const uint64_t read = SelfStats::thread_bytes_read - before;
+        lock.lock();
+        helper_bytes += read;
+        if (--pending == 0) done.notify_one();
+    }
+}
+
+ProcessesProvider::~ProcessesProvider() {
+    if (proc_fd >= 0) close(proc_fd);
+}
+
+bool ProcessesProvider::handleKey(int key) {
+    if (key != 's') return false;
+    sort_key = (sort_key + 1) % kSortKeys;
+    return true;
+}
+
+void ProcessesProvider::sample(Snapshot& out) {
+    static const uint32_t processes_name = metric_name("Processes");
+    static const uint32_t threads_name = metric_name("Threads");
+    static const uint32_t running_name = metric_name("Running");
+    static const uint32_t cpu_name = metric_name("CPU");
+    static const uint32_t rss_name = metric_name("RSS");
+    static const uint32_t state_name = metric_name("State");
+    static const uint32_t command_name = metric_name("Command");
+    static const char* const sort_names[] = {"CPU", "memory", "PID", "threads"};
+
+    if (proc_fd < 0) {
+        proc_fd = open((root + "/proc").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (proc_fd < 0) return out.message("Error: cannot open /proc");
+    }
+    if (!list_pids()) return out.message("Error: cannot read /proc");
+    double elapsed = scan();
+
+    size_t total_threads = 0, running = 0;
+    order.clear();
+    for (uint32_t slot = 0; slot < rows.size(); ++slot) {
+        if (!rows[slot].live) continue;
+        order.push_back(slot);
+        total_threads += rows[slot].threads;
+        if (rows[slot].state == 'R') ++running;
+    }
+    out.number(processes_name, order.size(), Unit::Count);
+    out.number(threads_name, total_threads, Unit::Count, kFieldInline);
+    out.number(running_name, running, Unit::Count, kFieldInline);
+    if (elapsed <= 0) out.message("Collecting statistics...");
+    out.separator();
+
+    // Сортируется только видимая часть таблицы
+    int key = sort_key;
+    size_t shown = std::min(order.size(), kMaxRows);
+    std::partial_sort(order.begin(), order.begin() + shown, order.end(), [&](uint32_t a, uint32_t b) {
+        const Process& x = rows[a];
+        const Process& y = rows[b];
+        switch (key) {
+            case SortMemory: if (x.rss != y.rss) return x.rss > y.rss; break;
+            case SortThreads: if (x.threads != y.threads) return x.threads > y.threads; break;
+            case SortCpu: if (x.cpu != y.cpu) return x.cpu > y.cpu; break;
+        }
+        return x.pid < y.pid;
+    });
+
+    char line[128];
+    snprintf(line, sizeof(line), "Top %zu by %s ('s' to change sort):", shown, sort_names[key]);
+    out.heading(line);
+    snprintf(line, sizeof(line), "%-7s   %-8s   %-10s   %-7s   %-5s   %s", "PID", "CPU", "RSS", "THREADS", "STATE", "COMMAND");
+    out.heading(line);
+    for (size_t i = 0; i < shown; ++i) {
+        const Process& process = rows[order[i]];
+        char pid[16];
+        snprintf(pid, sizeof(pid), "%d", process.pid);
+        out.text(0, pid, kFieldRowKey, 7);
+        out.number(cpu_name, process.cpu, Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+        out.number(rss_name, process.rss, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+        out.number(threads_name, process.threads, Unit::Count, kFieldInline | kFieldNoLabel, 7);
+        out.text(state_name, std::string_view(&process.state, 1), kFieldInline | kFieldNoLabel, 5);
+        out.text(command_name, process.command, kFieldInline | kFieldNoLabel);
+    }
+}
+
+bool ProcessesProvider::list_pids() {
+    struct linux_dirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+    pids.clear();
+    if (dirents.empty()) dirents.resize(64 * 1024);
+    if (lseek(proc_fd, 0, SEEK_SET) < 0) return false;
+    while (true) {
+        long count = syscall(SYS_getdents64, proc_fd, dirents.data(), dirents.size());
+        if (count < 0) return false;
+        if (count == 0) return true;
+        for (long offset = 0; offset < count;) {
+            auto* entry = reinterpret_cast<linux_dirent64*>(dirents.data() + offset);
+            offset += entry->d_reclen;
+            if (entry->d_name[0] < '1' || entry->d_name[0] > '9') continue;
+            pids.push_back(atoi(entry->d_name));
+        }
+    }
+}
+
+double ProcessesProvider::scan() {
+    ++generation;
+    pid_slots.resize(pids.size());
+    for (size_t i = 0; i < pids.size(); ++i) {
+        auto found = slots.find(pids[i]);
+        uint32_t slot;
+        if (found != slots.end()) {
+            slot = found->second;
+        } else {
+            if (free_slots.empty()) {
+                slot = rows.size();
+                rows.emplace_back();
+            } else {
+                slot = free_slots.back();
+                free_slots.pop_back();
+            }
+            slots.emplace(pids[i], slot);
+            rows[slot].pid = pids[i];
+            rows[slot].fresh = true;
+        }
+        rows[slot].generation = generation;
+        pid_slots[i] = slot;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = generation > 1 ? std::chrono::duration<double>(now - last_scan).count() : 0;
+    last_scan = now;
+
+    // Потоки пишут только в свои слоты, поэтому синхронизация не нужна
+    size_t parts = std::min<size_t>({pids.size() / kParallelChunk + 1, std::thread::hardware_concurrency(), 8});
+    if (parts <= 1) {
+        read_range(0, pids.size(), elapsed);
+    } else {
+        helpers.run(pids.size(), parts, [this, elapsed](size_t begin, size_t end) { read_range(begin, end, elapsed); });
+    }
+
+    // Завершившиеся процессы освобождают слоты
+    for (uint32_t slot = 0; slot < rows.size(); ++slot) {
+        Process& process = rows[slot];
+        if (process.pid == 0 || (process.generation == generation && process.live)) continue;
+        slots.erase(process.pid);
+        process.pid = 0;
+        process.live = false;
+        free_slots.push_back(slot);
+    }
+    return elapsed;
+}
+
+void ProcessesProvider::read_range(size_t begin, size_t end, double elapsed) {
+    char path[32];
+    char buf[1024];
+    for (size_t i = begin; i < end; ++i) {
+        Process& process = rows[pid_slots[i]];
+        snprintf(path, sizeof(path), "%d/stat", process.pid);
+        process.live = read_at(path, buf, sizeof(buf)) > 0 && parse_stat(buf, process, elapsed);
+    }
+}
+
+ssize_t ProcessesProvider::read_at(const char* path, char* buf, size_t size) const {
+    int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t count = ::read(fd, buf, size - 1);
+    close(fd);
+    if (count >= 0) buf[count] = '\0';
+    if (count > 0) SelfStats::thread_bytes_read += count;
+    return count;
+}
+
+bool ProcessesProvider::parse_stat(const char* buf, Process& process, double elapsed) {
+    const char* open_paren = strchr(buf, '(');
+    const char* close_paren = strrchr(buf, ')'); // имя команды может содержать скобки
+    if (!open_paren || !close_paren || close_paren[1] == '\0') return false;
+    const char* p = close_paren + 2;
+    char state = *p++;
+    uint64_t values[22] = {}; // поля с 4-го по 25-е
+    char* end;
+    for (uint64_t& value : values) {
+        value = strtoull(p, &end, 10);
+        if (end == p) break;
+        p = end;
+    }
+    uint64_t ticks = values[10] + values[11];
+    uint64_t start_time = values[18];
+
+    if (process.fresh || process.start_time != start_time) {
+        process.fresh = false;
+        process.start_time = start_time;
+        process.previous_ticks = ticks;
+        read_command(process, std::string_view(open_paren + 1, close_paren - open_paren - 1));
+    }
+    process.state = state;
+    process.ticks = ticks;
+    process.threads = static_cast<uint32_t>(values[16]);
+    process.rss = static_cast<double>(values[20]) * page_size;
+    process.cpu = elapsed > 0 ? (ticks - process.previous_ticks) * 100.0 / (elapsed * clock_ticks) : 0.0;
+    process.previous_ticks = ticks;
+    return true;
+}
+
+void ProcessesProvider::read_command(Process& process, std::string_view comm) {
+    char path[32];
+    char buf[128]; // длинные командные строки обрезаются, чтобы таблица не расползалась
+    snprintf(path, sizeof(path), "%d/cmdline", process.pid);
+    ssize_t count = read_at(path, buf, sizeof(buf));
+    while (count > 0 && buf[count - 1] == '\0') --count;
+    if (count <= 0) {
+        process.command.assign("[");
+        process.command.append(comm);
+        process.command += ']';
+        return;
+    }
+    std::replace(buf, buf + count, '\0', ' ');
+    process.command.assign(buf, count);
+}
+
+CgroupsProvider::~CgroupsProvider() {
+    if (inotify_fd >= 0) close(inotify_fd);
+    if (root_fd >= 0) close(root_fd);
+}
+
+bool CgroupsProvider::handleKey(int key) {
+    if (key == 's') sort_key = (sort_key + 1) % kSortKeys;
+    else if (key == 'c') depth_limit = depth_limit % kMaxDepth + 1;
+    else return false;
+    return true;
+}
+
+void CgroupsProvider::sample(Snapshot& out) {
+    static const uint32_t groups_name = metric_name("Groups");
+    static const uint32_t cpu_name = metric_name("CPU");
+    static const uint32_t memory_name = metric_name("Memory");
+    static const uint32_t limit_name = metric_name("Limit");
+    static const uint32_t read_name = metric_name("Read");
+    static const uint32_t write_name = metric_name("Write");
+    static const uint32_t cpu_pressure_name = metric_name("CPU pressure");
+    static const uint32_t memory_pressure_name = metric_name("Memory pressure");
+    static const uint32_t io_pressure_name = metric_name("IO pressure");
+    static const char* const sort_names[] = {"CPU", "memory", "IO"};
+
+    if (!tree_valid.exchange(true) && !rescan()) {
+        return out.message("Error: cgroup v2 is not mounted at /sys/fs/cgroup or /sys/fs/cgroup/unified");
+    }
+    if (root_fd < 0) return out.message("Error: cgroup v2 is not mounted at /sys/fs/cgroup or /sys/fs/cgroup/unified");
+    read_events();
+    // Переполнение очереди inotify вызывает полный обход, который тоже может не удаться
+    if (root_fd < 0 || groups.empty()) {
+        tree_valid = false;
+        return out.message("Error: cgroup v2 is not mounted at /sys/fs/cgroup or /sys/fs/cgroup/unified");
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = last_scan.time_since_epoch().count() ? std::chrono::duration<double>(now - last_scan).count() : 0.0;
+    last_scan = now;
+    ++generation;
+    // Свёрнутые ветки не читаются: их потребление уже учтено в видимом предке
+    int key = sort_key;
+    int depth = depth_limit;
+    size_t live = 0;
+    for (Group& group : groups) {
+        if (!group.live) continue;
+        ++live;
+        if (group.depth <= depth) update_usage(group, elapsed);
+    }
+    // У корня нет memory.current: его память — сумма групп верхнего уровня
+    if (groups[0].memory == 0) {
+        for (const Group& group : groups) {
+            if (group.live && group.depth == 1) groups[0].memory += group.memory;
+        }
+    }
+
+    char line[160];
+    out.number(groups_name, live, Unit::Count);
+    if (elapsed <= 0) out.message("Collecting statistics...");
+    out.separator();
+    snprintf(line, sizeof(line), "Sorted by %s ('s' to change), depth %d ('c' to change):", sort_names[key], depth);
+    out.heading(line);
+    snprintf(line, sizeof(line), "%-40s   %-8s   %-10s   %-10s   %-12s   %-12s   %-8s   %-8s   %s", "CGROUP", "CPU", "MEMORY", "LIMIT",
+             "READ", "WRITE", "PSI CPU", "PSI MEM", "PSI IO");
+    out.heading(line);
+
+    // Обход в глубину: дети каждой группы по убыванию выбранного потребления
+    build_children();
+    stack.assign(1, 0);
+    size_t shown = 0;
+    while (!stack.empty() && shown < kMaxRows) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        Group& group = groups[index];
+        std::vector<uint32_t>& kids = children[index];
+        size_t hidden = group.depth >= depth ? subtree_size(index) - 1 : 0;
+
+        row.assign(static_cast<size_t>(group.depth) * 2, ' ');
+        row += group.depth == 0 ? std::string_view("/") : std::string_view(group.path).substr(group.path.rfind('/') + 1);
+        if (hidden) row += " [+" + std::to_string(hidden) + "]";
+        out.text(0, row, kFieldRowKey, 40);
+        out.number(cpu_name, group.cpu, Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+        out.number(memory_name, group.memory, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+        uint64_t limit = 0;
+        if (read_limit(group, limit)) out.number(limit_name, limit, Unit::Bytes, kFieldInline | kFieldNoLabel, 10);
+        else out.text(limit_name, "max", kFieldInline | kFieldNoLabel, 10);
+        out.number(read_name, group.read_rate, Unit::BytesPerSecond, kFieldInline | kFieldNoLabel, 12);
+        out.number(write_name, group.write_rate, Unit::BytesPerSecond, kFieldInline | kFieldNoLabel, 12);
+        out.number(cpu_pressure_name, read_pressure(group, "cpu.pressure"), Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+        out.number(memory_pressure_name, read_pressure(group, "memory.pressure"), Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+        out.number(io_pressure_name, read_pressure(group, "io.pressure"), Unit::Percent, kFieldInline | kFieldNoLabel);
+        ++shown;
+
+        if (hidden) continue;
+        std::sort(kids.begin(), kids.end(), [&](uint32_t a, uint32_t b) {
+            const Group& x = groups[a];
+            const Group& y = groups[b];
+            switch (key) {
+                case SortMemory: if (x.memory != y.memory) return x.memory > y.memory; break;
+                case SortIo: if (x.read_rate + x.write_rate != y.read_rate + y.write_rate) return x.read_rate + x.write_rate > y.read_rate + y.write_rate; break;
+                case SortCpu: if (x.cpu != y.cpu) return x.cpu > y.cpu; break;
+            }
+            return x.path < y.path;
+        });
+        // В стек в обратном порядке, чтобы самый «тяжёлый» ребёнок вышел первым
+        stack.insert(stack.end(), kids.rbegin(), kids.rend());
+    }
+    if (shown == kMaxRows && !stack.empty()) out.message("... more groups hidden, press 'c' to collapse the tree");
+}
+
+bool CgroupsProvider::rescan() {
+    if (root_fd >= 0) close(root_fd);
+    if (inotify_fd >= 0) close(inotify_fd);
+    root_fd = inotify_fd = -1;
+    groups.clear();
+    free_slots.clear();
+    by_path.clear();
+    by_watch.clear();
+    for (const char* candidate : {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}) {
+        mount = root + candidate;
+        if (access((mount + "/cgroup.controllers").c_str(), F_OK) == 0) break;
+        mount.clear();
+    }
+    if (mount.empty()) return false;
+    root_fd = open(mount.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (root_fd < 0) return false;
+    add_tree("", 0, 0);
+    return true;
+}
+
+void CgroupsProvider::add_tree(const std::string& path, uint32_t parent, int depth) {
+    if (by_path.count(path)) return;
+    uint32_t index;
+    if (free_slots.empty()) {
+        index = static_cast<uint32_t>(groups.size());
+        groups.emplace_back();
+    } else {
+        index = free_slots.back();
+        free_slots.pop_back();
+        groups[index] = Group();
+    }
+    Group& group = groups[index];
+    group.path = path;
+    group.parent = parent;
+    group.depth = depth;
+    group.live = true;
+    by_path.emplace(path, index);
+    const std::string dir = path.empty() ? mount : mount + "/" + path;
+    if (inotify_fd >= 0) {
+        group.watch = inotify_add_watch(inotify_fd, dir.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+        if (group.watch >= 0) by_watch[group.watch] = index;
+    }
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_directory(ec)) continue;
+        std::string name = entry.path().filename().string();
+        add_tree(path.empty() ? name : path + "/" + name, index, depth + 1);
+    }
+}
+
+void CgroupsProvider::remove_tree(const std::string& path) {
+    auto it = by_path.find(path);
+    if (it == by_path.end() || it->second == 0) return;
+    uint32_t index = it->second;
+    // Потомки удаляются раньше родителя, но и при пропущенном событии ветка уходит целиком
+    std::string prefix = path + "/";
+    for (auto child = by_path.begin(); child != by_path.end();) {
+        if (child->first.compare(0, prefix.size(), prefix) == 0) {
+            release(child->second);
+            child = by_path.erase(child);
+        } else {
+            ++child;
+        }
+    }
+    release(index);
+    by_path.erase(path);
+}
+
+void CgroupsProvider::release(uint32_t index) {
+    Group& group = groups[index];
+    if (group.watch >= 0) by_watch.erase(group.watch); // ядро само снимает наблюдение с удалённого каталога
+    group.live = false;
+    group.path.clear();
+    free_slots.push_back(index);
+}
+
+void CgroupsProvider::read_events() {
+    if (inotify_fd < 0) return;
+    events.resize(64 * 1024);
+    while (true) {
+        ssize_t count = ::read(inotify_fd, events.data(), events.size());
+        if (count <= 0) break;
+        for (ssize_t pos = 0; pos < count;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(events.data() + pos);
+            pos += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                rescan();
+                return;
+            }
+            auto it = by_watch.find(event->wd);
+            if (it == by_watch.end() || !(event->mask & IN_ISDIR) || event->len == 0) continue;
+            const Group& parent = groups[it->second];
+            std::string path = parent.path.empty() ? std::string(event->name) : parent.path + "/" + event->name;
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) add_tree(path, it->second, parent.depth + 1);
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) remove_tree(path);
+        }
+    }
+}
+
+void CgroupsProvider::build_children() {
+    children.resize(groups.size());
+    for (auto& kids : children) kids.clear();
+    for (uint32_t i = 1; i < groups.size(); ++i) {
+        if (groups[i].live) children[groups[i].parent].push_back(i);
+    }
+}
+
+size_t CgroupsProvider::subtree_size(uint32_t index) const {
+    size_t size = 1;
+    for (uint32_t child : children[index]) size += subtree_size(child);
+    return size;
+}
+
+ssize_t CgroupsProvider::read_file(const Group& group, const char* file, char* buf, size_t size) const {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s%s%s", group.path.c_str(), group.path.empty() ? "" : "/", file);
+    int fd = openat(root_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t count = ::read(fd, buf, size - 1);
+    close(fd);
+    if (count < 0) return -1;
+    buf[count] = '\0';
+    SelfStats::thread_bytes_read += count;
+    return count;
+}
+
+void CgroupsProvider::update_usage(Group& group, double elapsed) {
+    char buf[4096];
+    uint64_t usage = 0, read_bytes = 0, write_bytes = 0, memory = 0;
+    ssize_t count = read_file(group, "cpu.stat", buf, sizeof(buf));
+    if (count > 0) {
+        std::string_view text(buf, count), line;
+        while (next_line(text, line)) {
+            if (line.compare(0, 11, "usage_usec ") != 0) continue;
+            const char* p = line.data() + 10;
+            parse_u64(p, line.data() + line.size(), usage);
+            break;
+        }
+    }
+    count = read_file(group, "memory.current", buf, sizeof(buf));
+    if (count > 0) {
+        const char* p = buf;
+        parse_u64(p, buf + count, memory);
+    }
+    count = read_file(group, "io.stat", buf, sizeof(buf));
+    if (count > 0) {
+        std::string_view text(buf, count), line;
+        while (next_line(text, line)) {
+            read_bytes += stat_value(line, " rbytes=");
+            write_bytes += stat_value(line, " wbytes=");
+        }
+    }
+    bool rates = elapsed > 0 && group.sampled + 1 == generation;
+    group.sampled = generation;
+    group.cpu = rates && usage >= group.usage_usec ? (usage - group.usage_usec) / (elapsed * 1e4) : 0.0;
+    group.read_rate = rates && read_bytes >= group.read_bytes ? (read_bytes - group.read_bytes) / elapsed : 0.0;
+    group.write_rate = rates && write_bytes >= group.write_bytes ? (write_bytes - group.write_bytes) / elapsed : 0.0;
+    group.usage_usec = usage;
+    group.read_bytes = read_bytes;
+    group.write_bytes = write_bytes;
+    group.memory = static_cast<double>(memory);
+}
+
+uint64_t CgroupsProvider::stat_value(std::string_view line, std::string_view key) {
+    size_t pos = line.find(key);
+    if (pos == std::string_view::npos) return 0;
+    const char* p = line.data() + pos + key.size();
+    uint64_t value = 0;
+    parse_u64(p, line.data() + line.size(), value);
+    return value;
+}
+
+bool CgroupsProvider::read_limit(const Group& group, uint64_t& limit) const {
+    char buf[32];
+    ssize_t count = read_file(group, "memory.max", buf, sizeof(buf));
+    const char* p = buf;
+    return count > 0 && parse_u64(p, buf + count, limit);
+}
+
+double CgroupsProvider::read_pressure(const Group& group, const char* file) const {
+    char buf[256];
+    ssize_t count = read_file(group, file, buf, sizeof(buf));
+    if (count <= 0) return 0.0;
+    const char* avg10 = strstr(buf, "avg10=");
+    double value = 0.0;
+    if (avg10) std::from_chars(avg10 + 6, buf + count, value);
+    return value;
+}
+
+void MonitorProvider::sample(Snapshot& out) {
+    static const uint32_t cpu_name = metric_name("CPU");
+    static const uint32_t cpu_time_name = metric_name("CPU time");
+    static const uint32_t rss_name = metric_name("RSS");
+    static const uint32_t threads_name = metric_name("Threads");
+    static const uint32_t forks_name = metric_name("Forks");
+    static const uint32_t samples_name = metric_name("Samples");
+    static const uint32_t runs_name = metric_name("Runs");
+    static const uint32_t p50_name = metric_name("p50");
+    static const uint32_t p90_name = metric_name("p90");
+    static const uint32_t p99_name = metric_name("p99");
+    static const uint32_t max_name = metric_name("Max");
+    static const uint32_t read_name = metric_name("Read");
+    static const uint32_t timeouts_name = metric_name("Timeouts");
+    static const uint32_t failures_name = metric_name("Failures");
+    static const uint32_t output_name = metric_name("Output");
+
+    if (!stat_file.is_open() && !stat_file.open("/proc/self/stat")) return out.message("Error: cannot open /proc/self/stat");
+    uint64_t ticks = 0, threads = 0, rss_pages = 0;
+    if (!parse_stat(stat_file.read(), ticks, threads, rss_pages)) return out.message("Error: cannot parse /proc/self/stat");
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_sample).count();
+    double cpu = previous_ticks && elapsed > 0 ? (ticks - previous_ticks) * 100.0 / (elapsed * clock_ticks) : 0.0;
+    previous_ticks = ticks;
+    last_sample = now;
+
+    out.heading("Process:");
+    out.number(cpu_name, cpu, Unit::Percent, kFieldHistory);
+    out.number(cpu_time_name, ticks * 1e6 / clock_ticks, Unit::Microseconds, kFieldInline);
+    out.number(rss_name, static_cast<double>(rss_pages) * page_size, Unit::Bytes, kFieldHistory);
+    out.number(threads_name, threads, Unit::Count, kFieldInline);
+    out.number(forks_name, CommandRunner::spawned.load(std::memory_order_relaxed), Unit::Count, kFieldInline);
+    out.separator();
+
+    SelfStats& stats = SelfStats::instance();
+    char line[160];
+    out.heading("Sampling latency:");
+    snprintf(line, sizeof(line), "%-14s   %-8s   %-9s   %-9s   %-9s   %-9s   %-6s   %s", "SECTION", "SAMPLES", "P50", "P90", "P99",
+             "MAX", "FORKS", "READ");
+    out.heading(line);
+    for (size_t i = 0, count = stats.provider_count(); i < count; ++i) {
+        const SelfStats::Provider& provider = stats.provider_at(i);
+        out.text(0, provider.name, kFieldRowKey, 14);
+        out.number(samples_name, provider.latency.count(), Unit::Count, kFieldInline | kFieldNoLabel, 8);
+        append_latency(out, provider.latency, p50_name, p90_name, p99_name, max_name);
+        out.number(forks_name, provider.commands.load(std::memory_order_relaxed), Unit::Count, kFieldInline | kFieldNoLabel, 6);
+        out.number(read_name, provider.bytes_read.load(std::memory_order_relaxed), Unit::Bytes, kFieldInline | kFieldNoLabel);
+    }
+
+    size_t commands = stats.command_count();
+    if (commands == 0) return;
+    out.separator();
+    out.heading("External commands:");
+    snprintf(line, sizeof(line), "%-14s   %-8s   %-9s   %-9s   %-9s   %-9s   %-8s   %-8s   %s", "COMMAND", "RUNS", "P50", "P90",
+             "P99", "MAX", "TIMEOUTS", "FAILURES", "OUTPUT");
+    out.heading(line);
+    for (size_t i = 0; i < commands; ++i) {
+        const SelfStats::Command& command = stats.command_at(i);
+        out.text(0, command.name, kFieldRowKey, 14);
+        out.number(runs_name, command.latency.count(), Unit::Count, kFieldInline | kFieldNoLabel, 8);
+        append_latency(out, command.latency, p50_name, p90_name, p99_name, max_name);
+        out.number(timeouts_name, command.timeouts.load(std::memory_order_relaxed), Unit::Count, kFieldInline | kFieldNoLabel, 8);
+        out.number(failures_name, command.failures.load(std::memory_order_relaxed), Unit::Count, kFieldInline | kFieldNoLabel, 8);
+        out.number(output_name, command.output_bytes.load(std::memory_order_relaxed), Unit::Bytes, kFieldInline | kFieldNoLabel);
+    }
+}
+
+void MonitorProvider::append_latency(Snapshot& out, const LatencyHistogram& latency, uint32_t p50, uint32_t p90, uint32_t p99, uint32_t max) {
+    const uint8_t flags = kFieldInline | kFieldNoLabel;
+    out.number(p50, latency.percentile(0.5) / 1000.0, Unit::Microseconds, flags, 9);
+    out.number(p90, latency.percentile(0.9) / 1000.0, Unit::Microseconds, flags, 9);
+    out.number(p99, latency.percentile(0.99) / 1000.0, Unit::Microseconds, flags, 9);
+    out.number(max, latency.max() / 1000.0, Unit::Microseconds, flags, 9);
+}
+
+bool MonitorProvider::parse_stat(std::string_view text, uint64_t& ticks, uint64_t& threads, uint64_t& rss_pages) {
+    size_t close_paren = text.rfind(')');
+    if (close_paren == std::string_view::npos) return false;
+    text.remove_prefix(close_paren + 1);
+    uint64_t utime = 0, stime = 0;
+    int found = 0;
+    for (int field = 3; field <= 24 && !text.empty(); ++field) {
+        text.remove_prefix(std::min(text.find_first_not_of(' '), text.size()));
+        std::string_view token = text.substr(0, text.find(' '));
+        text.remove_prefix(token.size());
+        uint64_t* target = field == 14 ? &utime : field == 15 ? &stime : field == 20 ? &threads : field == 24 ? &rss_pages : nullptr;
+        if (target && std::from_chars(token.data(), token.data() + token.size(), *target).ec == std::errc()) ++found;
+    }
+    ticks = utime + stime;
+    return found == 4;
+}
@@ -0,0 +1,464 @@
+// Запись сессии в файл и её воспроизведение
+#include "sysinfo.h"
+
+bool SessionRecorder::open(const std::string& path, const std::vector<std::string>& names) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    std::string header(record_format::kMagic, sizeof(record_format::kMagic));
+    put_raw<uint64_t>(header, 0);
+    put_raw<uint32_t>(header, static_cast<uint32_t>(names.size()));
+    for (const std::string& name : names) put_string(header, name);
+    sections.assign(names.size(), Section());
+    size = 0;
+    failed = false;
+    return write_at(header, 0);
+}
+
+void SessionRecorder::append(size_t index, const Snapshot& snapshot, int64_t time_ms) {
+    if (!ok()) return;
+    Section& section = sections[index];
+    if (section.schema_offset == 0 || !same_shape(section.schema, snapshot)) {
+        scratch.clear();
+        serialize_snapshot(scratch, snapshot);
+        // Разделы, у которых часто меняется состав полей (число строк таблицы), ограничены по объёму схем.
+        // Бюджет пополняется за время с прошлого пополнения, в том числе при пропуске отсчёта
+        if (section.schema_offset != 0) {
+            double seconds = std::max<int64_t>(0, time_ms - section.refill_time) / 1000.0;
+            section.budget = std::min(kSchemaBurst, section.budget + seconds * kSchemaBytesPerSecond);
+            section.refill_time = time_ms;
+            if (section.budget < 0) {
+                // Столбцы прежней схемы не подходят к новому снимку: отсчёт пропускается, пропуск отмечается в файле
+                if (section.dropped++ == 0) section.dropped_first = time_ms;
+                section.dropped_last = time_ms;
+                return;
+            }
+        }
+        flush_block(index);
+        write_dropped(index);
+        section.budget -= scratch.size();
+        section.refill_time = time_ms;
+        set_schema(section, snapshot);
+        payload.clear();
+        put_varint(payload, index);
+        payload += scratch;
+        section.schema_offset = write_chunk('S', payload);
+    }
+    section.times.push_back(time_ms);
+    const std::vector<Field>& fields = snapshot.items();
+    for (size_t k = 0; k < section.numeric.size(); ++k) {
+        double value = fields[section.numeric[k]].value.number * section.scales[k];
+        section.columns[k].push_back(std::isfinite(value) ? std::llround(value) : 0);
+    }
+    // Текст, меняющийся от опроса к опросу (команды процессов, строки групп), идёт столбцом номеров, а не новой схемой
+    const std::vector<Field>& schema = section.schema.items();
+    for (size_t k = 0; k < section.texts.size(); ++k) {
+        const size_t at = section.texts[k];
+        section.text_columns[k].push_back(string_id(section, section.schema.text_of(schema[at]), snapshot.text_of(fields[at])));
+    }
+    if (section.times.size() == record_format::kBlockTicks) flush_block(index);
+}
+
+void SessionRecorder::close() {
+    if (fd < 0) return;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        flush_block(i);
+        write_dropped(i);
+    }
+    if (!pending.empty()) write_index();
+    ::close(fd);
+    fd = -1;
+}
+
+bool SessionRecorder::same_shape(const Snapshot& a, const Snapshot& b) {
+    const std::vector<Field>& x = a.items();
+    const std::vector<Field>& y = b.items();
+    if (x.size() != y.size()) return false;
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (x[i].name != y[i].name || x[i].kind != y[i].kind || x[i].unit != y[i].unit ||
+            x[i].flags != y[i].flags || x[i].width != y[i].width) {
+            return false;
+        }
+        if (x[i].kind == FieldKind::Heading && a.text_of(x[i]) != b.text_of(y[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SessionRecorder::set_schema(Section& section, const Snapshot& snapshot) {
+    section.schema = snapshot;
+    section.numeric.clear();
+    section.scales.clear();
+    section.texts.clear();
+    const std::vector<Field>& fields = snapshot.items();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].kind == FieldKind::Text) section.texts.push_back(i);
+        if (fields[i].kind != FieldKind::Number) continue;
+        section.numeric.push_back(i);
+        section.scales.push_back(record_scale(fields[i].unit));
+    }
+    section.columns.resize(section.numeric.size());
+    for (auto& column : section.columns) column.clear();
+    section.text_columns.resize(section.texts.size());
+    for (auto& column : section.text_columns) column.clear();
+}
+
+int64_t SessionRecorder::string_id(Section& section, std::string_view schema_text, std::string_view text) {
+    if (text == schema_text) return 0;
+    auto [it, inserted] = section.string_ids.try_emplace(std::string(text), section.strings.size() + 1);
+    if (inserted) section.strings.emplace_back(text);
+    return it->second;
+}
+
+bool SessionRecorder::write_at(const std::string& data, uint64_t offset) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t count = pwrite(fd, data.data() + done, data.size() - done, offset + done);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return !(failed = true);
+        done += count;
+    }
+    size = std::max<uint64_t>(size, offset + data.size());
+    return true;
+}
+
+uint64_t SessionRecorder::write_chunk(char type, const std::string& data) {
+    uint64_t offset = size;
+    std::string chunk(1, type);
+    put_raw<uint32_t>(chunk, static_cast<uint32_t>(data.size()));
+    chunk += data;
+    write_at(chunk, offset);
+    return offset;
+}
+
+void SessionRecorder::write_dropped(size_t index) {
+    Section& section = sections[index];
+    if (section.dropped == 0 || !ok()) return;
+    payload.clear();
+    put_varint(payload, index);
+    put_varint(payload, zigzag(section.dropped_first));
+    put_varint(payload, static_cast<uint64_t>(section.dropped_last - section.dropped_first));
+    put_varint(payload, section.dropped);
+    write_chunk('D', payload);
+    section.dropped = 0;
+}
+
+void SessionRecorder::flush_block(size_t index) {
+    Section& section = sections[index];
+    if (section.times.empty() || !ok()) return;
+    const size_t n = section.times.size();
+    payload.clear();
+    put_varint(payload, index);
+    put_varint(payload, section.schema_offset);
+    put_varint(payload, n);
+    put_varint(payload, zigzag(section.times[0]));
+    for (size_t i = 1; i < n; ++i) put_varint(payload, zigzag(section.times[i] - section.times[i - 1]));
+    for (const std::vector<int64_t>& column : section.columns) encode_column(column);
+    put_varint(payload, section.strings.size());
+    for (const std::string& text : section.strings) put_string(payload, text);
+    for (const std::vector<int64_t>& column : section.text_columns) encode_column(column);
+
+    uint64_t offset = write_chunk('B', payload);
+    pending.push_back({index, section.times.front(), section.times.back(), offset});
+    section.times.clear();
+    for (auto& column : section.columns) column.clear();
+    for (auto& column : section.text_columns) column.clear();
+    section.strings.clear();
+    section.string_ids.clear();
+    if (pending.size() >= record_format::kBlocksPerIndex) write_index();
+}
+
+void SessionRecorder::encode_column(const std::vector<int64_t>& column) {
+    const size_t n = column.size();
+    int64_t low = column[0], high = column[0];
+    int64_t delta_low = 0, delta_high = 0;
+    for (size_t i = 1; i < n; ++i) {
+        low = std::min(low, column[i]);
+        high = std::max(high, column[i]);
+        int64_t delta = column[i] - column[i - 1];
+        if (i == 1 || delta < delta_low) delta_low = delta;
+        if (i == 1 || delta > delta_high) delta_high = delta;
+    }
+    int plain_width = bit_width(static_cast<uint64_t>(high - low));
+    int delta_width = bit_width(static_cast<uint64_t>(delta_high - delta_low));
+    bool deltas = n > 1 && delta_width * (n - 1) < plain_width * n;
+
+    packed.clear();
+    if (deltas) {
+        payload += static_cast<char>(0x80 | delta_width);
+        put_varint(payload, zigzag(column[0]));
+        put_varint(payload, zigzag(delta_low));
+        for (size_t i = 1; i < n; ++i) packed.push_back(static_cast<uint64_t>(column[i] - column[i - 1] - delta_low));
+        pack_bits(packed, delta_width);
+    } else {
+        payload += static_cast<char>(plain_width);
+        put_varint(payload, zigzag(low));
+        for (int64_t value : column) packed.push_back(static_cast<uint64_t>(value - low));
+        pack_bits(packed, plain_width);
+    }
+}
+
+void SessionRecorder::pack_bits(const std::vector<uint64_t>& values, int width) {
+    if (width == 0) return;
+    unsigned __int128 accumulator = 0;
+    int filled = 0;
+    for (uint64_t value : values) {
+        accumulator |= static_cast<unsigned __int128>(value) << filled;
+        filled += width;
+        while (filled >= 8) {
+            payload += static_cast<char>(accumulator & 0xff);
+            accumulator >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0) payload += static_cast<char>(accumulator & 0xff);
+}
+
+void SessionRecorder::write_index() {
+    payload.clear();
+    put_varint(payload, last_index);
+    put_varint(payload, pending.size());
+    for (const IndexEntry& entry : pending) {
+        put_varint(payload, entry.section);
+        put_varint(payload, zigzag(entry.first));
+        put_varint(payload, static_cast<uint64_t>(entry.last - entry.first));
+        put_varint(payload, entry.offset);
+    }
+    pending.clear();
+    last_index = write_chunk('I', payload);
+    std::string position;
+    put_raw<uint64_t>(position, last_index);
+    write_at(position, record_format::kIndexOffsetPos);
+}
+
+SessionReplay::~SessionReplay() {
+    if (data) munmap(const_cast<char*>(data), length);
+}
+
+bool SessionReplay::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        error = path + ": " + strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    length = info.st_size;
+    void* mapped = length ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error = path + ": cannot map the file";
+        return false;
+    }
+    data = static_cast<const char*>(mapped);
+
+    std::string_view in(data, length);
+    uint64_t last_index;
+    uint32_t count;
+    if (in.substr(0, sizeof(record_format::kMagic)) != std::string_view(record_format::kMagic, sizeof(record_format::kMagic))) {
+        error = path + ": not a SysInfo recording";
+        return false;
+    }
+    in.remove_prefix(sizeof(record_format::kMagic));
+    if (!get_raw(in, last_index) || !get_raw(in, count)) {
+        error = path + ": truncated header";
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view name;
+        if (!get_string(in, name)) {
+            error = path + ": truncated header";
+            return false;
+        }
+        names.emplace_back(name);
+    }
+    sections.assign(count, Section());
+    load_index(last_index, length - in.size());
+    for (Section& section : sections) {
+        std::sort(section.blocks.begin(), section.blocks.end(),
+                  [](const Block& a, const Block& b) { return a.first < b.first; });
+        for (const Block& block : section.blocks) {
+            first_time = std::min(first_time, block.first);
+            last_time = std::max(last_time, block.last);
+        }
+    }
+    if (first_time > last_time) {
+        error = path + ": the recording has no samples";
+        return false;
+    }
+    position_ms = first_time;
+    return true;
+}
+
+void SessionReplay::advance(double seconds) {
+    if (!is_paused) seek(position_ms + static_cast<int64_t>(seconds * 1000.0 * speed()));
+}
+
+bool SessionReplay::poll(size_t index) {
+    Section& section = sections[index];
+    auto after = std::upper_bound(section.blocks.begin(), section.blocks.end(), position_ms,
+                                  [](int64_t time, const Block& block) { return time < block.first; });
+    if (after == section.blocks.begin()) {
+        bool changed = section.has_sample;
+        section.has_sample = false;
+        return changed;
+    }
+    size_t block = after - section.blocks.begin() - 1;
+    if (block != section.decoded_block && !decode(section, block)) return false;
+    size_t tick = std::upper_bound(section.times.begin(), section.times.end(), position_ms) - section.times.begin() - 1;
+    if (section.has_sample && tick == section.tick) return false;
+    section.tick = tick;
+    section.has_sample = true;
+    section.current = section.schema;
+    for (size_t k = 0; k < section.numeric.size(); ++k) {
+        section.current.set_number(section.numeric[k], section.columns[k][tick] / section.scales[k]);
+    }
+    for (size_t k = 0; k < section.texts.size(); ++k) {
+        int64_t id = section.text_columns[k][tick];
+        if (id > 0) section.current.set_text(section.texts[k], section.strings[id - 1]);
+    }
+    return true;
+}
+
+bool SessionReplay::chunk_at(uint64_t offset, char& type, std::string_view& payload) const {
+    if (offset + record_format::kChunkHeader > length) return false;
+    uint32_t size;
+    memcpy(&size, data + offset + 1, sizeof(size));
+    if (offset + record_format::kChunkHeader + size > length) return false;
+    type = data[offset];
+    payload = std::string_view(data + offset + record_format::kChunkHeader, size);
+    return true;
+}
+
+void SessionReplay::add_block(uint64_t section, int64_t first, int64_t last, uint64_t offset) {
+    if (section < sections.size()) sections[section].blocks.push_back({first, last, offset});
+}
+
+void SessionReplay::load_index(uint64_t last_index, uint64_t data_start) {
+    uint64_t tail = data_start;
+    for (uint64_t offset = last_index; offset != 0;) {
+        char type;
+        std::string_view in;
+        if (!chunk_at(offset, type, in) || type != 'I') break;
+        if (offset == last_index) tail = offset + record_format::kChunkHeader + in.size();
+        uint64_t previous, count;
+        if (!get_varint(in, previous) || !get_varint(in, count)) break;
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t section, first, span, block;
+            if (!get_varint(in, section) || !get_varint(in, first) || !get_varint(in, span) || !get_varint(in, block)) break;
+            add_block(section, unzigzag(first), unzigzag(first) + static_cast<int64_t>(span), block);
+        }
+        offset = previous < offset ? previous : 0;
+    }
+    char type;
+    std::string_view in;
+    for (uint64_t offset = tail; chunk_at(offset, type, in); offset += record_format::kChunkHeader + in.size()) {
+        if (type != 'B') continue;
+        uint64_t section, schema, n, first;
+        std::string_view block = in;
+        if (!get_varint(block, section) || !get_varint(block, schema) || !get_varint(block, n) || !get_varint(block, first)) continue;
+        int64_t time = unzigzag(first);
+        for (uint64_t i = 1; i < n; ++i) {
+            uint64_t delta;
+            if (!get_varint(block, delta)) break;
+            time += unzigzag(delta);
+        }
+        add_block(section, unzigzag(first), time, offset);
+    }
+}
+
+bool SessionReplay::load_schema(Section& section, uint64_t offset) {
+    if (section.schema_offset == offset) return true;
+    char type;
+    std::string_view in;
+    uint64_t index;
+    if (!chunk_at(offset, type, in) || type != 'S' || !get_varint(in, index)) return false;
+    section.schema.clear();
+    if (!deserialize_snapshot(in, section.schema)) return false;
+    section.schema_offset = offset;
+    section.numeric.clear();
+    section.scales.clear();
+    section.texts.clear();
+    const std::vector<Field>& fields = section.schema.items();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].kind == FieldKind::Text) section.texts.push_back(i);
+        if (fields[i].kind != FieldKind::Number) continue;
+        section.numeric.push_back(i);
+        section.scales.push_back(record_scale(fields[i].unit));
+    }
+    return true;
+}
+
+bool SessionReplay::decode(Section& section, size_t block) {
+    char type;
+    std::string_view in;
+    uint64_t index, schema, n, first;
+    section.decoded_block = SIZE_MAX;
+    section.has_sample = false;
+    if (!chunk_at(section.blocks[block].offset, type, in) || type != 'B') return false;
+    if (!get_varint(in, index) || !get_varint(in, schema) || !get_varint(in, n) || !get_varint(in, first)) return false;
+    // Писатель не делает блоков длиннее kBlockTicks: большее n — порча файла, а не повод выделять память
+    if (n == 0 || n > record_format::kBlockTicks) return false;
+    if (!load_schema(section, schema)) return false;
+    section.times.assign(1, unzigzag(first));
+    for (uint64_t i = 1; i < n; ++i) {
+        uint64_t delta;
+        if (!get_varint(in, delta)) return false;
+        section.times.push_back(section.times.back() + unzigzag(delta));
+    }
+    section.columns.resize(section.numeric.size());
+    for (std::vector<int64_t>& column : section.columns) {
+        if (!decode_column(in, n, column)) return false;
+    }
+    uint64_t count;
+    if (!get_varint(in, count) || count > in.size()) return false;
+    section.strings.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string_view text;
+        if (!get_string(in, text)) return false;
+        section.strings.push_back(text);
+    }
+    section.text_columns.resize(section.texts.size());
+    for (std::vector<int64_t>& column : section.text_columns) {
+        if (!decode_column(in, n, column)) return false;
+        for (int64_t id : column) {
+            if (id < 0 || static_cast<uint64_t>(id) > count) return false;
+        }
+    }
+    section.decoded_block = block;
+    return true;
+}
+
+bool SessionReplay::decode_column(std::string_view& in, size_t n, std::vector<int64_t>& column) {
+    if (in.empty()) return false;
+    uint8_t header = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    bool deltas = header & 0x80;
+    int width = header & 0x7f;
+    if (width > 64) return false;
+    uint64_t start = 0, base;
+    if (deltas && !get_varint(in, start)) return false;
+    if (!get_varint(in, base)) return false;
+    size_t count = deltas ? n - 1 : n;
+    size_t bytes = (count * width + 7) / 8;
+    if (in.size() < bytes) return false;
+
+    column.clear();
+    if (deltas) column.push_back(unzigzag(start));
+    unsigned __int128 accumulator = 0;
+    int filled = 0;
+    const uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+    size_t pos = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (filled < width) {
+            accumulator |= static_cast<unsigned __int128>(static_cast<uint8_t>(in[pos++])) << filled;
+            filled += 8;
+        }
+        int64_t value = unzigzag(base) + static_cast<int64_t>(static_cast<uint64_t>(accumulator) & mask);
+        accumulator >>= width;
+        filled -= width;
+        column.push_back(deltas ? column.back() + value : value);
+    }
+    in.remove_prefix(bytes);
+    return true;
+}
@@ -0,0 +1,168 @@
+// Хранение истории и планировщик опроса разделов
+#include "sysinfo.h"
+
+void HistoryStore::record(size_t provider, const Snapshot& snapshot) {
+    int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - origin).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    occurrences.clear();
+    for (const Field& field : snapshot.items()) {
+        if (field.kind != FieldKind::Number || !(field.flags & kFieldHistory)) continue;
+        // Одинаковые имена (например, temp1 у разных датчиков) различаются порядковым номером
+        uint32_t occurrence = 0;
+        for (auto& seen : occurrences) {
+            if (seen.first == field.name) occurrence = ++seen.second;
+        }
+        if (occurrence == 0) occurrences.emplace_back(field.name, 0);
+        Series* series = find_or_create(provider, field.name, occurrence, field.unit);
+        if (series) append(*series, static_cast<float>(field.value.number), seconds);
+    }
+}
+
+void HistoryStore::series_of(size_t provider, std::vector<size_t>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    out.clear();
+    for (size_t i = 0; i < series.size(); ++i) {
+        if (series[i]->provider == provider) out.push_back(i);
+    }
+}
+
+size_t HistoryStore::read(size_t index, Resolution resolution, float* values, size_t max_points, Rollup& window, uint32_t& name, Unit& unit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Series& s = *series[index];
+    name = s.name;
+    unit = s.unit;
+    size_t total = resolution == Raw ? s.raw.size() : resolution == Minute ? s.minute.size() : s.quarter.size();
+    size_t count = std::min(total, max_points);
+    window = Rollup{std::numeric_limits<float>::max(), 0, std::numeric_limits<float>::lowest()};
+    double sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t at = total - count + i;
+        Rollup point;
+        if (resolution == Raw) {
+            float value = s.raw.at(at);
+            point = Rollup{value, value, value};
+        } else {
+            point = resolution == Minute ? s.minute.at(at) : s.quarter.at(at);
+        }
+        values[i] = point.avg;
+        window.min = std::min(window.min, point.min);
+        window.max = std::max(window.max, point.max);
+        sum += point.avg;
+    }
+    window.avg = count ? static_cast<float>(sum / count) : 0;
+    if (count == 0) window = Rollup{};
+    return count;
+}
+
+HistoryStore::Series* HistoryStore::find_or_create(size_t provider, uint32_t name, uint32_t occurrence, Unit unit) {
+    for (auto& s : series) {
+        if (s->provider == provider && s->name == name && s->occurrence == occurrence) return s.get();
+    }
+    if (series.size() >= kMaxSeries) return nullptr;
+    series.push_back(std::make_unique<Series>());
+    Series& s = *series.back();
+    s.provider = provider;
+    s.name = name;
+    s.occurrence = occurrence;
+    s.unit = unit;
+    return &s;
+}
+
+void HistoryStore::append(Series& s, float value, int64_t seconds) {
+    s.raw.push(value);
+    int64_t minute = seconds / 60;
+    if (s.minute_acc.count > 0 && s.minute_acc.bucket != minute) {
+        Rollup rollup = s.minute_acc.take();
+        s.minute.push(rollup);
+        int64_t quarter = s.minute_acc.bucket / 15;
+        if (s.quarter_acc.count > 0 && s.quarter_acc.bucket != quarter) s.quarter.push(s.quarter_acc.take());
+        s.quarter_acc.bucket = quarter;
+        s.quarter_acc.add(rollup.min, rollup.avg, rollup.max, 1);
+    }
+    s.minute_acc.bucket = minute;
+    s.minute_acc.add(value, value, value, 1);
+}
+
+SamplingScheduler::SamplingScheduler(const std::vector<std::unique_ptr<InfoProvider>>& providers, const std::vector<std::string>& names,
+                  size_t worker_count, HistoryStore* history) : entries(providers.size()), history(history) {
+    for (size_t i = 0; i < providers.size(); ++i) {
+        entries[i].provider = providers[i].get();
+        entries[i].stats = &SelfStats::instance().provider(names[i]);
+    }
+    worker_count = std::max<size_t>(1, std::min(worker_count, providers.size()));
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+SamplingScheduler::~SamplingScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void SamplingScheduler::request(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entries[index];
+        if (entry.busy) entry.pending = true;
+        else entry.due = Clock::now();
+    }
+    wakeup.notify_one();
+}
+
+bool SamplingScheduler::poll(size_t index) {
+    Entry& entry = entries[index];
+    if (!entry.slot.update()) return false;
+    entry.has_sample = true;
+    return true;
+}
+
+void SamplingScheduler::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        Entry* next = nullptr;
+        for (Entry& entry : entries) {
+            if (!entry.busy && (!next || entry.due < next->due)) next = &entry;
+        }
+        if (!next || next->due == Clock::time_point::max()) {
+            wakeup.wait(lock);
+            continue;
+        }
+        if (next->due > Clock::now()) {
+            wakeup.wait_until(lock, next->due);
+            continue;
+        }
+        Entry& entry = *next;
+        entry.busy = true;
+        lock.unlock();
+
+        Snapshot& snapshot = entry.slot.back();
+        snapshot.clear();
+        uint64_t bytes_read = SelfStats::thread_bytes_read;
+        uint64_t commands = SelfStats::thread_commands;
+        auto started = Clock::now();
+        entry.provider->sample(snapshot);
+        entry.stats->latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count());
+        entry.stats->bytes_read.fetch_add(SelfStats::thread_bytes_read - bytes_read, std::memory_order_relaxed);
+        entry.stats->commands.fetch_add(SelfStats::thread_commands - commands, std::memory_order_relaxed);
+        if (history) history->record(&entry - entries.data(), snapshot);
+        entry.slot.publish();
+
+        lock.lock();
+        entry.busy = false;
+        auto interval = entry.provider->refreshInterval();
+        if (entry.pending) {
+            entry.pending = false;
+            entry.due = Clock::now();
+        } else if (interval.count() > 0) {
+            entry.due = Clock::now() + interval;
+        } else {
+            entry.due = Clock::time_point::max(); // статические данные читаются один раз
+        }
+        wakeup.notify_one();
+    }
+}
@@ -1,403 +1,660 @@
 #include <ncurses.h>
-#include <string>
-#include <vector>
-#include <sstream>
-#include <fstream>
-#include <sys/statvfs.h>
-#include <unistd.h>
-#include <cstdio>
-#include <filesystem>
-#include <chrono>
-#include <thread>
-#include <sys/wait.h>
-#include <signal.h>
-#include <memory>
-
-// Утилитная функция для выполнения команд
-std::string exec_command(const char* cmd, int timeout_seconds = 5) {
-    std::string result;
-    int pipefd[2];
-    pipe(pipefd);
-    pid_t pid = fork();
-    if (pid == 0) {
-        close(pipefd[0]);
-        dup2(pipefd[1], STDOUT_FILENO);
-        dup2(pipefd[1], STDERR_FILENO);
-        close(pipefd[1]);
-        execl("/bin/sh", "sh", "-c", cmd, (char*)nullptr);
-        _exit(127);
+#include "sysinfo.h"
+
+// Параметры командной строки
+struct Options {
+    bool headless = false;
+    bool jsonl = false;
+    int interval_ms = 1000;
+    std::string prometheus; // "127.0.0.1:9100", ":9100" или "unix:/path"
+    InterfaceFilter interfaces;
+    std::string record; // файл записи сеанса
+    std::string replay; // файл для воспроизведения
+    std::string agent;  // адрес, на котором агент отдаёт кадры снимков агрегатору
+    std::vector<std::string> aggregate; // адреса агентов
+};
+
+void print_usage(const char* program) {
+    printf("Usage: %s [options]\n"
+           "  --jsonl               headless: write one JSON line per interval to stdout\n"
+           "  --prometheus ADDR     headless: serve /metrics on HOST:PORT, :PORT or unix:PATH\n"
+           "  --interval MS         headless output interval in milliseconds (default 1000)\n"
+           "  --record FILE         headless: record every sample to a compact binary FILE\n"
+           "  --replay FILE         browse a recorded FILE in the interactive interface\n"
+           "  --agent ADDR          headless: stream samples to aggregators on HOST:PORT, :PORT or unix:PATH\n"
+           "  --aggregate ADDRS     watch comma-separated agent addresses in a fleet overview\n"
+           "  --net-include GLOBS   show only network interfaces matching comma-separated globs\n"
+           "  --net-exclude GLOBS   hide network interfaces matching comma-separated globs, e.g. 'veth*'\n"
+           "  --help                show this help\n"
+           "Without options the interactive ncurses interface is started.\n",
+           program);
+}
+
+// Дописывает шаблоны из списка через запятую
+void split_patterns(std::string_view list, std::vector<std::string>& out) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view pattern = list.substr(0, comma);
+        if (!pattern.empty()) out.emplace_back(pattern);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
     }
-    close(pipefd[1]);
-    char buffer[128];
-    std::vector<char> output;
-    auto start = std::chrono::steady_clock::now();
-    while (true) {
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - start).count();
-        if (elapsed >= timeout_seconds) {
-            kill(pid, SIGKILL);
-            break;
-        }
-        int status; // Объявляем переменную status здесь
-        if (waitpid(pid, &status, WNOHANG) == pid) {
-            break;
-        }
-        ssize_t count = read(pipefd[0], buffer, sizeof(buffer) - 1);
-        if (count <= 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+}
+
+// Возвращает false, если аргументы некорректны
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--jsonl") {
+            options.jsonl = options.headless = true;
+        } else if (arg == "--prometheus" && i + 1 < argc) {
+            options.prometheus = argv[++i];
+            options.headless = true;
+        } else if (arg == "--interval" && i + 1 < argc) {
+            options.interval_ms = atoi(argv[++i]);
+            if (options.interval_ms <= 0) return false;
+        } else if (arg == "--record" && i + 1 < argc) {
+            options.record = argv[++i];
+            options.headless = true;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            options.replay = argv[++i];
+        } else if (arg == "--agent" && i + 1 < argc) {
+            options.agent = argv[++i];
+            options.headless = true;
+        } else if (arg == "--aggregate" && i + 1 < argc) {
+            split_patterns(argv[++i], options.aggregate);
+            if (options.aggregate.empty()) return false;
+        } else if (arg == "--net-include" && i + 1 < argc) {
+            split_patterns(argv[++i], options.interfaces.include);
+        } else if (arg == "--net-exclude" && i + 1 < argc) {
+            split_patterns(argv[++i], options.interfaces.exclude);
+        } else {
+            return false;
         }
-        buffer[count] = '\0';
-        output.insert(output.end(), buffer, buffer + count);
     }
-    close(pipefd[0]);
-    int status; // Объявляем переменную status здесь для второго waitpid
-    waitpid(pid, &status, 0);
-    result.assign(output.begin(), output.end());
-    if (result.empty()) return "Error: command timed out or failed";
-    return result;
+    // Воспроизведение и агрегатор — интерактивные режимы, их нельзя совмещать друг с другом и с режимом без интерфейса
+    int interactive = !options.replay.empty() + !options.aggregate.empty();
+    return interactive == 0 || (interactive == 1 && !options.headless);
 }
 
-// Утилитная функция для проверки наличия утилиты
-bool is_utility_installed(const std::string& util) {
-    return std::filesystem::exists("/usr/sbin/" + util) || std::filesystem::exists("/usr/bin/" + util);
+// Дописывает строку в JSON с экранированием
+void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
 }
 
-// Базовый класс для провайдеров информации
-class InfoProvider {
-public:
-    virtual std::string getInfo() = 0;
-    virtual ~InfoProvider() {}
-};
+const char* unit_name(Unit unit) {
+    switch (unit) {
+        case Unit::Count: return "count";
+        case Unit::Percent: return "percent";
+        case Unit::Bytes: return "bytes";
+        case Unit::BytesPerSecond: return "bytes_per_second";
+        case Unit::PerSecond: return "per_second";
+        case Unit::KiloHertz: return "khz";
+        case Unit::MilliCelsius: return "millicelsius";
+        case Unit::Rpm: return "rpm";
+        case Unit::MicroWatts: return "microwatts";
+        case Unit::Milliseconds: return "milliseconds";
+        case Unit::Microseconds: return "microseconds";
+        case Unit::None: break;
+    }
+    return "";
+}
 
-// Провайдер для CPU
-class CPUInfoProvider : public InfoProvider {
-public:
-    std::string getInfo() override {
-        std::string output = exec_command("lscpu 2>/dev/null");
-        if (output.find("Error") != std::string::npos) {
-            return "Error: lscpu utility not found\nPlease install util-linux package";
-        }
-        std::istringstream iss(output);
-        std::string line, result;
-        while (std::getline(iss, line)) {
-            if (line.find("Model name:") != std::string::npos ||
-                line.find("CPU(s):") != std::string::npos ||
-                line.find("Thread(s) per core:") != std::string::npos ||
-                line.find("Core(s) per socket:") != std::string::npos ||
-                line.find("Socket(s):") != std::string::npos ||
-                line.find("CPU MHz:") != std::string::npos) {
-                result += line + "\n";
+// Снимок в виде массива JSON: числа и строки с именами, заголовки групп отдельными элементами
+void append_snapshot_json(std::string& out, const Snapshot& snapshot) {
+    MetricNames& names = MetricNames::instance();
+    out += '[';
+    bool first = true;
+    char number[32];
+    std::string_view key;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind == FieldKind::Separator) continue;
+        if (field.flags & kFieldRowKey) {
+            key = snapshot.text_of(field);
+            continue;
+        }
+        if (!(field.flags & kFieldInline)) key = {};
+        if (!first) out += ',';
+        first = false;
+        if (field.kind == FieldKind::Heading) {
+            out += "{\"heading\":";
+            append_json_string(out, snapshot.text_of(field));
+            out += '}';
+            continue;
+        }
+        out += "{\"name\":";
+        append_json_string(out, names.name(field.name));
+        if (!key.empty()) {
+            out += ",\"key\":";
+            append_json_string(out, key);
+        }
+        out += ",\"value\":";
+        if (field.kind == FieldKind::Number) {
+            snprintf(number, sizeof(number), "%.17g", field.value.number);
+            out += std::isfinite(field.value.number) ? number : "null";
+            if (field.unit != Unit::None) {
+                out += ",\"unit\":\"";
+                out += unit_name(field.unit);
+                out += '"';
             }
+        } else {
+            append_json_string(out, snapshot.text_of(field));
         }
-        return result.empty() ? "No CPU data found" : result;
+        out += '}';
     }
-};
+    out += ']';
+}
 
-// Провайдер для System Usage
-class SystemUsageProvider : public InfoProvider {
-public:
-    std::string getInfo() override {
-        std::string result;
-        std::ifstream stat_file("/proc/stat");
-        if (!stat_file.is_open()) return "Error: cannot open /proc/stat";
-        std::string line;
-        std::getline(stat_file, line);
-        std::istringstream iss(line);
-        std::string cpu;
-        long user, nice, system, idle, iowait, irq, softirq;
-        iss >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq;
-        long total = user + nice + system + idle + iowait + irq + softirq;
-        long idle_total = idle + iowait;
-        static long prev_total = 0, prev_idle = 0;
-        long delta_total = total - prev_total;
-        long delta_idle = idle_total - prev_idle;
-        double cpu_usage = (delta_total - delta_idle) * 100.0 / delta_total;
-        prev_total = total;
-        prev_idle = idle_total;
-        result += "CPU Usage: " + std::to_string(cpu_usage).substr(0, 5) + "%\n";
-        result += "-------------------\n";
-
-        std::ifstream meminfo("/proc/meminfo");
-        if (!meminfo.is_open()) return "Error: cannot open /proc/meminfo";
-        std::string mem_line;
-        long mem_total = 0, mem_free = 0, mem_available = 0;
-        while (std::getline(meminfo, mem_line)) {
-            if (mem_line.find("MemTotal:") != std::string::npos) {
-                sscanf(mem_line.c_str(), "MemTotal: %ld kB", &mem_total);
-            } else if (mem_line.find("MemFree:") != std::string::npos) {
-                sscanf(mem_line.c_str(), "MemFree: %ld kB", &mem_free);
-            } else if (mem_line.find("MemAvailable:") != std::string::npos) {
-                sscanf(mem_line.c_str(), "MemAvailable: %ld kB", &mem_available);
-            }
+// Имя метрики Prometheus: sysinfo_<раздел>_<метрика>[_<единица>], только [a-z0-9_]
+void append_prometheus_name(std::string& out, std::string_view text) {
+    bool underscore = !out.empty() && out.back() == '_';
+    for (char c : text) {
+        if (isalnum(static_cast<unsigned char>(c))) {
+            out += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            underscore = false;
+        } else if (!underscore) {
+            out += '_';
+            underscore = true;
         }
-        double mem_usage = (mem_total - mem_available) * 100.0 / mem_total;
-        result += "Memory Usage: " + std::to_string(mem_usage).substr(0, 5) + "%\n";
-        result += "-------------------\n";
+    }
+    while (!out.empty() && out.back() == '_') out.pop_back();
+}
 
-        struct statvfs stat;
-        if (statvfs("/", &stat) == 0) {
-            double disk_total = stat.f_blocks * stat.f_frsize;
-            double disk_free = stat.f_bfree * stat.f_frsize;
-            double disk_usage = (disk_total - disk_free) * 100.0 / disk_total;
-            result += "Disk Usage (/): " + std::to_string(disk_usage).substr(0, 5) + "%\n";
-        } else {
-            result += "Disk Usage: Error\n";
-        }
-        result += "-------------------\n";
-
-        std::ifstream netdev("/proc/net/dev");
-        if (!netdev.is_open()) return "Error: cannot open /proc/net/dev";
-        std::string net_line;
-        while (std::getline(netdev, net_line)) {
-            if (net_line.find("enp") != std::string::npos || net_line.find("wlp") != std::string::npos) {
-                std::istringstream net_iss(net_line);
-                std::string iface, rx, tx;
-                net_iss >> iface >> rx;
-                for (int i = 0; i < 7; ++i) net_iss >> tx;
-                result += "Network (" + iface.substr(0, iface.size() - 1) + "):\nRX: " + rx + " bytes\nTX: " + tx + " bytes\n";
-                result += "-------------------\n";
-            }
-        }
-        return result;
+// Prometheus ожидает базовые единицы: герцы, градусы, ватты
+double prometheus_value(double value, Unit unit, const char*& suffix) {
+    switch (unit) {
+        case Unit::Percent: suffix = "_percent"; return value;
+        case Unit::Bytes: suffix = "_bytes"; return value;
+        case Unit::BytesPerSecond: suffix = "_bytes_per_second"; return value;
+        case Unit::PerSecond: suffix = "_per_second"; return value;
+        case Unit::KiloHertz: suffix = "_hertz"; return value * 1000.0;
+        case Unit::MilliCelsius: suffix = "_celsius"; return value / 1000.0;
+        case Unit::Rpm: suffix = "_rpm"; return value;
+        case Unit::MicroWatts: suffix = "_watts"; return value / 1000000.0;
+        case Unit::Milliseconds: suffix = "_seconds"; return value / 1000.0;
+        case Unit::Microseconds: suffix = "_seconds"; return value / 1000000.0;
+        case Unit::Count:
+        case Unit::None: break;
     }
-};
+    suffix = "";
+    return value;
+}
 
-// Провайдер для Temperatures
-class TemperaturesProvider : public InfoProvider {
+// Текст для /metrics. Серии собираются в переиспользуемые буферы и сериализуются
+// только при появлении новых снимков; запрос просто отдаёт готовый буфер
+class PrometheusText {
 public:
-    std::string getInfo() override {
-        std::string output = exec_command("sensors 2>/dev/null");
-        if (output.find("Error") != std::string::npos) {
-            return "Error: sensors utility not found\nPlease install lm_sensors and run 'sudo sensors-detect'";
-        }
-        std::istringstream iss(output);
-        std::string line, result;
-        while (std::getline(iss, line)) {
-            result += line + "\n";
-            if (line.empty()) {
-                result += "-------------------\n";
+    void rebuild(const std::vector<const Snapshot*>& snapshots, const std::vector<std::string>& sections) {
+        used = 0;
+        for (size_t i = 0; i < snapshots.size(); ++i) {
+            if (snapshots[i]) collect(*snapshots[i], sections[i]);
+        }
+        // Все отсчёты одной метрики должны идти подряд под одной строкой TYPE
+        order.resize(used);
+        for (size_t i = 0; i < used; ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return series[a].metric < series[b].metric; });
+
+        body.clear();
+        char number[32];
+        const std::string* previous = nullptr;
+        for (size_t index : order) {
+            const Series& s = series[index];
+            if (!previous || *previous != s.metric) {
+                body += "# TYPE ";
+                body += s.metric;
+                body += " gauge\n";
+                previous = &s.metric;
             }
+            body += s.metric;
+            body += s.labels;
+            snprintf(number, sizeof(number), " %.17g\n", s.value);
+            body += number;
         }
-        return result.empty() ? "No temperature data found\nRun 'sudo sensors-detect' to configure sensors" : result;
     }
-};
 
-// Провайдер для Motherboard
-class MotherboardProvider : public InfoProvider {
-public:
-    std::string getInfo() override {
-        if (getuid() != 0) {
-            return "Warning: dmidecode requires root privileges\nRun with sudo for full info";
-        }
-        std::string output = exec_command("dmidecode -t baseboard 2>/dev/null");
-        if (output.find("Error") != std::string::npos) {
-            return "Error: dmidecode utility not found\nPlease install dmidecode package\nTry: sudo dnf install dmidecode";
+    const std::string& text() const { return body; }
+
+private:
+    struct Series {
+        std::string metric;
+        std::string labels;
+        double value;
+    };
+
+    std::vector<Series> series;
+    std::vector<size_t> order;
+    size_t used = 0;
+    std::string body;
+    std::string group;
+
+    static void append_label(std::string& out, const char* key, std::string_view value) {
+        out += out.empty() ? '{' : ',';
+        out += key;
+        out += "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') out += '\\';
+            if (c == '\n') out += "\\n";
+            else out += c;
         }
-        return output.empty() ? "No motherboard data found" : output;
+        out += '"';
     }
-};
 
-// Провайдер для Memory
-class MemoryProvider : public InfoProvider {
-public:
-    std::string getInfo() override {
-        if (getuid() != 0) {
-            return "Warning: dmidecode requires root privileges\nRun with sudo for full info";
-        }
-        if (!is_utility_installed("dmidecode")) {
-            return "Error: dmidecode utility not found\nPlease install dmidecode package";
-        }
-        std::string output = exec_command("dmidecode -t memory 2>/dev/null");
-        std::istringstream iss(output);
-        std::string line, result;
-        bool in_memory_device = false;
-        while (std::getline(iss, line)) {
-            if (line.find("Memory Device") != std::string::npos) {
-                if (in_memory_device) {
-                    result += "-------------------\n";
-                }
-                in_memory_device = true;
+    void collect(const Snapshot& snapshot, const std::string& section) {
+        MetricNames& names = MetricNames::instance();
+        group.clear();
+        std::string_view key;
+        // Встроенное поле вне строки таблицы (max и crit датчика) различается именем поля, которое оно продолжает
+        uint32_t parent = 0;
+        for (const Field& field : snapshot.items()) {
+            if (field.kind == FieldKind::Separator) {
+                group.clear();
+                parent = 0;
+                continue;
+            }
+            if (field.kind == FieldKind::Heading) {
+                group.assign(snapshot.text_of(field));
+                while (!group.empty() && group.back() == ':') group.pop_back();
+                continue;
+            }
+            if (field.flags & kFieldRowKey) {
+                key = snapshot.text_of(field);
                 continue;
             }
-            if (in_memory_device && (line.find("Size:") != std::string::npos ||
-                                     line.find("Type:") != std::string::npos ||
-                                     line.find("Speed:") != std::string::npos ||
-                                     line.find("Manufacturer:") != std::string::npos ||
-                                     line.find("Part Number:") != std::string::npos)) {
-                result += line + "\n";
+            const bool inline_field = field.flags & kFieldInline;
+            if (!inline_field) {
+                key = {};
+                parent = field.name;
             }
+            if (field.kind != FieldKind::Number || field.name == 0 || !std::isfinite(field.value.number)) continue;
+
+            if (used == series.size()) series.emplace_back();
+            Series& s = series[used++];
+            const char* suffix;
+            s.value = prometheus_value(field.value.number, field.unit, suffix);
+            s.metric.assign("sysinfo_");
+            append_prometheus_name(s.metric, section);
+            s.metric += '_';
+            append_prometheus_name(s.metric, names.name(field.name));
+            s.metric += suffix;
+            s.labels.clear();
+            if (!group.empty()) append_label(s.labels, "group", group);
+            if (!key.empty()) append_label(s.labels, "key", key);
+            else if (inline_field && parent != 0) append_label(s.labels, "field", names.name(parent));
+            if (!s.labels.empty()) s.labels += '}';
         }
-        return result.empty() ? "No memory data found" : result;
     }
 };
 
-// Провайдер для Disks
-class DisksProvider : public InfoProvider {
+// Флаг завершения по SIGINT/SIGTERM для режимов без интерфейса
+volatile sig_atomic_t stop_requested = 0;
+
+void request_stop(int) { stop_requested = 1; }
+
+// Время отсчёта в записи — миллисекунды Unix: при воспроизведении видны настоящие дата и время
+int64_t wall_clock_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Режим без интерфейса: JSON Lines в stdout, HTTP-эндпоинт /metrics, запись сеанса в файл
+// и/или поток кадров для агрегатора. Один поток с poll обслуживает сокеты и таймер вывода, опрос идёт в планировщике
+class HeadlessExporter {
 public:
-    std::string getInfo() override {
-        std::string output = exec_command("lsblk -d -o NAME,SIZE,MODEL 2>/dev/null");
-        if (output.find("Error") != std::string::npos) {
-            return "Error: lsblk utility not found\nPlease install util-linux package";
+    explicit HeadlessExporter(Options options) : options(std::move(options)) {
+        make_providers(providers, sections, this->options.interfaces);
+        providers.push_back(std::make_unique<MonitorProvider>());
+        sections.push_back("Monitor");
+    }
+
+    ~HeadlessExporter() {
+        for (Client& client : clients) close(client.fd);
+        if (listen_fd >= 0) close(listen_fd);
+        if (agent_fd >= 0) close(agent_fd);
+        for (const std::string& path : unix_paths) unlink(path.c_str());
+    }
+
+    int run() {
+        if (!options.prometheus.empty() && (listen_fd = open_listener(options.prometheus)) < 0) {
+            fprintf(stderr, "Error: cannot listen on %s: %s\n", options.prometheus.c_str(), strerror(errno));
+            return 1;
         }
-        std::istringstream iss(output);
-        std::string line, result;
-        bool first = true;
-        while (std::getline(iss, line)) {
-            if (line.find("NAME") != std::string::npos) continue;
-            if (!first) {
-                result += "-------------------\n";
+        if (!options.agent.empty()) {
+            if ((agent_fd = open_listener(options.agent)) < 0) {
+                fprintf(stderr, "Error: cannot listen on %s: %s\n", options.agent.c_str(), strerror(errno));
+                return 1;
             }
-            result += line + "\n";
+            char host[256] = {};
+            gethostname(host, sizeof(host) - 1);
+            publisher = std::make_unique<FleetPublisher>(sections, host);
+        }
+        if (!options.record.empty() && !recorder.open(options.record, sections)) {
+            fprintf(stderr, "Error: cannot create %s: %s\n", options.record.c_str(), strerror(errno));
+            return 1;
+        }
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, request_stop);
+        signal(SIGTERM, request_stop);
+        SamplingScheduler scheduler(providers, sections, 4);
+        UeventMonitor uevents([&](std::string_view subsystem) { on_device_change(providers, scheduler, subsystem); });
+        std::vector<const Snapshot*> latest(providers.size(), nullptr);
+        std::vector<pollfd> fds;
+        auto next_tick = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.interval_ms);
+
+        while (!stop_requested) {
+            bool changed = false;
+            for (size_t i = 0; i < providers.size(); ++i) {
+                if (scheduler.poll(i)) {
+                    latest[i] = &scheduler.latest(i);
+                    changed = true;
+                    if (!options.record.empty()) recorder.append(i, *latest[i], wall_clock_ms());
+                    if (publisher) publisher->publish(i, *latest[i]);
+                }
+            }
+            if (!options.record.empty() && !recorder.ok()) {
+                fprintf(stderr, "Error: cannot write %s: %s\n", options.record.c_str(), strerror(errno));
+                return 1;
+            }
+            if (changed && listen_fd >= 0) prometheus.rebuild(latest, sections);
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next_tick) {
+                if (options.jsonl && !write_json_line(latest)) return 0; // stdout закрыт
+                next_tick += std::chrono::milliseconds(options.interval_ms);
+                if (next_tick < now) next_tick = now + std::chrono::milliseconds(options.interval_ms);
+            }
+
+            fds.clear();
+            if (listen_fd >= 0) fds.push_back({listen_fd, POLLIN, 0});
+            for (const Client& client : clients) {
+                fds.push_back({client.fd, static_cast<short>(client.response.empty() ? POLLIN : POLLOUT), 0});
+            }
+            const size_t clients_end = fds.size();
+            if (agent_fd >= 0) {
+                fds.push_back({agent_fd, POLLIN, 0});
+                publisher->add_pollfds(fds);
+            }
+            // Новые снимки проверяются не реже раза в 100 мс
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_tick - now).count();
+            int ready = poll(fds.data(), fds.size(), static_cast<int>(std::clamp<long long>(wait, 0, 100)));
+            if (ready <= 0) continue;
+
+            size_t k = 0;
+            if (listen_fd >= 0 && fds[k++].revents) accept_clients();
+            for (size_t i = 0; k < clients_end; ++k) {
+                Client& client = clients[i];
+                bool keep = fds[k].revents == 0 || serve(client);
+                if (keep) {
+                    ++i;
+                } else {
+                    close(client.fd);
+                    clients.erase(clients.begin() + i);
+                }
+            }
+            if (agent_fd >= 0) serve_aggregators(fds.data() + clients_end, latest, scheduler);
+        }
+        return 0;
+    }
+
+private:
+    struct Client {
+        int fd;
+        std::string request;
+        std::string response;
+        size_t sent = 0;
+    };
+
+    static constexpr size_t kMaxClients = 16;
+
+    Options options;
+    std::vector<std::unique_ptr<InfoProvider>> providers;
+    std::vector<std::string> sections;
+    PrometheusText prometheus;
+    SessionRecorder recorder;
+    std::string line;
+    int listen_fd = -1;
+    int agent_fd = -1;
+    std::vector<std::string> unix_paths;
+    std::vector<Client> clients;
+    std::unique_ptr<FleetPublisher> publisher;
+    std::vector<FleetPublisher::KeyRequest> keys;
+
+    bool write_json_line(const std::vector<const Snapshot*>& latest) {
+        line.assign("{\"timestamp\":");
+        line += std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch()).count());
+        line += ",\"sections\":{";
+        bool first = true;
+        for (size_t i = 0; i < latest.size(); ++i) {
+            if (!latest[i]) continue;
+            if (!first) line += ',';
             first = false;
+            append_json_string(line, sections[i]);
+            line += ':';
+            append_snapshot_json(line, *latest[i]);
         }
-        return result.empty() ? "No disk data found" : result;
+        line += "}}\n";
+        return fwrite(line.data(), 1, line.size(), stdout) == line.size() && fflush(stdout) == 0;
     }
-};
 
-// Провайдер для Network
-class NetworkProvider : public InfoProvider {
-public:
-    std::string getInfo() override {
-        std::string result;
-        std::string ip_output = exec_command("ip -br link 2>/dev/null");
-        if (ip_output.find("Error") != std::string::npos) {
-            return "Error: ip utility not found\nPlease install iproute package";
-        }
-        std::istringstream iss(ip_output);
-        std::string line;
-        while (std::getline(iss, line)) {
-            if (line.find("enp") != std::string::npos || line.find("wlp") != std::string::npos) {
-                std::istringstream line_iss(line);
-                std::string iface, state;
-                line_iss >> iface >> state;
-                result += "Adapter: " + iface + "\nState: " + state + "\n";
-                result += "-------------------\n";
+    // Возвращает слушающий сокет или -1 с errno
+    int open_listener(const std::string& addr) {
+        sockaddr_storage storage;
+        socklen_t length;
+        if (!parse_socket_address(addr, storage, length)) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (storage.ss_family == AF_UNIX) {
+            unix_paths.push_back(addr.substr(5));
+            unlink(unix_paths.back().c_str());
+        }
+        int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        if (storage.ss_family != AF_UNIX) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, reinterpret_cast<sockaddr*>(&storage), length) != 0 || listen(fd, 64) != 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return -1;
+        }
+        return fd;
+    }
+
+    // Новые агрегаторы, их подписки и клавиши; fds начинается с сокета агента, дальше соединения publisher
+    void serve_aggregators(const pollfd* fds, const std::vector<const Snapshot*>& latest, SamplingScheduler& scheduler) {
+        keys.clear();
+        publisher->service(fds + 1, latest, keys);
+        for (const FleetPublisher::KeyRequest& request : keys) {
+            if (request.key == 'r') providers[request.section]->invalidate();
+            else if (!providers[request.section]->handleKey(request.key)) continue;
+            scheduler.request(request.section);
+        }
+        if (fds[0].revents) {
+            while (true) {
+                int fd = accept4(agent_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                if (fd < 0) break;
+                publisher->add_peer(fd);
             }
         }
-        if (is_utility_installed("bluetoothctl")) {
-            std::string bt_output = exec_command("bluetoothctl show 2>/dev/null");
-            if (bt_output.find("Controller") != std::string::npos) {
-                result += "Bluetooth: Enabled\n";
-            } else {
-                result += "Bluetooth: Disabled or not found\n";
+    }
+
+    void accept_clients() {
+        while (true) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd < 0) return;
+            if (clients.size() >= kMaxClients) {
+                close(fd);
+                continue;
             }
-        } else {
-            result += "Bluetooth: bluetoothctl not found\n";
+            clients.push_back({fd, {}, {}, 0});
         }
-        return result;
+    }
+
+    // Читает запрос и отправляет ответ; false — соединение можно закрыть
+    bool serve(Client& client) {
+        if (client.response.empty()) {
+            char buf[1024];
+            ssize_t count = read(client.fd, buf, sizeof(buf));
+            if (count == 0 || (count < 0 && errno != EAGAIN && errno != EINTR)) return false;
+            if (count > 0) client.request.append(buf, count);
+            if (client.request.size() > 8192) return false;
+            if (client.request.find("\r\n\r\n") == std::string::npos) return true;
+
+            bool metrics = client.request.compare(0, 13, "GET /metrics ") == 0 || client.request.compare(0, 6, "GET / ") == 0;
+            const std::string& body = metrics ? prometheus.text() : std::string("Not Found\n");
+            client.response = metrics ? "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                      : "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n";
+            client.response += "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+            client.response += body;
+        }
+        ssize_t count = write(client.fd, client.response.data() + client.sent, client.response.size() - client.sent);
+        if (count < 0) return errno == EAGAIN || errno == EINTR;
+        client.sent += count;
+        return client.sent < client.response.size();
     }
 };
 
-// Провайдер для GPU
-class GPUProvider : public InfoProvider {
+// Окно информации с отслеживанием изменений: раскладка строк кэшируется по (версии содержимого, ширине),
+// на экран выводятся только строки, отличающиеся от предыдущего кадра
+class InfoRenderer {
 public:
-    std::string getInfo() override {
-        std::string result;
-        std::string lspci_output = exec_command("lspci | grep -E 'VGA|3D' 2>/dev/null");
-        if (lspci_output.find("Error") != std::string::npos) {
-            return "Error: lspci utility not found\nPlease install pciutils package";
-        }
-        std::istringstream lspci_iss(lspci_output);
-        std::string lspci_line;
-        bool first_gpu = true;
-        while (std::getline(lspci_iss, lspci_line)) {
-            if (!first_gpu) {
-                result += "-------------------\n";
-            }
-            result += "GPU Model: " + lspci_line + "\n";
-            first_gpu = false;
-        }
-
-        if (is_utility_installed("nvidia-smi")) {
-            std::string nvidia_output = exec_command("nvidia-smi --query-gpu=name,driver_version,memory.total,memory.used,utilization.gpu,temperature.gpu --format=csv,noheader 2>/dev/null", 3);
-            if (!nvidia_output.empty() && nvidia_output.find("Error") == std::string::npos) {
-                std::istringstream nvidia_iss(nvidia_output);
-                std::string nvidia_line;
-                while (std::getline(nvidia_iss, nvidia_line)) {
-                    std::istringstream line_iss(nvidia_line);
-                    std::string name, driver, mem_total, mem_used, util, temp;
-                    std::getline(line_iss, name, ',');
-                    std::getline(line_iss, driver, ',');
-                    std::getline(line_iss, mem_total, ',');
-                    std::getline(line_iss, mem_used, ',');
-                    std::getline(line_iss, util, ',');
-                    std::getline(line_iss, temp, ',');
-                    result += "-------------------\n";
-                    result += "NVIDIA GPU Details:\n";
-                    result += "Name: " + name + "\n";
-                    result += "Driver Version: " + driver + "\n";
-                    result += "Memory Total: " + mem_total + "\n";
-                    result += "Memory Used: " + mem_used + "\n";
-                    result += "GPU Utilization: " + util + "\n";
-                    result += "Temperature: " + temp + "\n";
-                }
-            } else {
-                result += "-------------------\n";
-                result += "NVIDIA GPU: Data unavailable\n";
+    // Следующий кадр перерисует рамку и все строки (после resize или первого вывода)
+    void invalidate() {
+        frame.clear();
+        drawn_title.clear();
+    }
+
+    // Пересчитывает переносы только при смене версии или ширины; возвращает число строк
+    size_t layout(const std::string& text, uint64_t version, int width) {
+        if (version == layout_version && width == layout_width) return spans.size();
+        layout_version = version;
+        layout_width = width;
+        spans.clear();
+        const size_t first = std::max(width, 4);
+        const size_t rest = first - 2; // продолжение строки идёт с отступом в два пробела
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if (end == std::string::npos) end = text.size();
+            size_t length = end - pos;
+            size_t chunk = std::min(length, first);
+            spans.push_back({static_cast<uint32_t>(pos), static_cast<uint32_t>(chunk), false});
+            for (size_t done = chunk; done < length; done += chunk) {
+                chunk = std::min(length - done, rest);
+                spans.push_back({static_cast<uint32_t>(pos + done), static_cast<uint32_t>(chunk), true});
             }
+            pos = end + 1;
         }
+        return spans.size();
+    }
 
-        if (is_utility_installed("radeontop")) {
-            std::string amd_output = exec_command("LC_ALL=en_US.UTF-8 radeontop -d -l 1 2>/dev/null", 3);
-            if (!amd_output.empty() && amd_output.find("Error") == std::string::npos) {
-                std::istringstream amd_iss(amd_output);
-                std::string amd_line;
-                result += "-------------------\n";
-                result += "AMD GPU Details:\n";
-                while (std::getline(amd_iss, amd_line)) {
-                    if (amd_line.find("Dumping to") != std::string::npos) continue;
-                    if (amd_line.find("Unknown Radeon card") != std::string::npos) {
-                        result += "Warning: " + amd_line + "\n";
-                        continue;
-                    }
-                    std::istringstream line_iss(amd_line);
-                    std::string token;
-                    while (line_iss >> token) {
-                        if (token == "bus") {
-                            line_iss >> token;
-                            result += "Bus: " + token + "\n";
-                        } else if (token == "gpu") {
-                            line_iss >> token;
-                            result += "GPU Usage: " + token + "\n";
-                        } else if (token == "vram") {
-                            line_iss >> token;
-                            result += "VRAM Usage: " + token + "\n";
-                        } else if (token == "mclk") {
-                            line_iss >> token;
-                            result += "Memory Clock: " + token + " (percentage of max)\n";
-                        } else if (token == "sclk") {
-                            line_iss >> token;
-                            result += "Shader Clock: " + token + "\n";
-                        }
-                    }
-                }
-            } else {
-                result += "-------------------\n";
-                result += "AMD GPU: Data unavailable\n";
-            }
+    // Выводит видимые строки в окно без wrefresh; вызывающий делает doupdate()
+    void draw(WINDOW* win, const std::string& text, const std::string& title, size_t scroll_offset) {
+        int height, width;
+        getmaxyx(win, height, width);
+        const int rows = std::max(0, height - 2);
+        const size_t inner = static_cast<size_t>(std::max(0, width - 2));
+
+        if (title != drawn_title || frame.size() != static_cast<size_t>(rows)) {
+            werase(win);
+            box(win, 0, 0);
+            wattron(win, COLOR_PAIR(3));
+            mvwprintw(win, 0, 1, "%s", title.c_str());
+            wattroff(win, COLOR_PAIR(3));
+            drawn_title = title;
+            frame.assign(rows, std::string());
         }
 
-        return result.empty() ? "No GPU data found" : result;
+        wattron(win, COLOR_PAIR(2));
+        for (int y = 0; y < rows; ++y) {
+            row.clear();
+            size_t index = scroll_offset + y;
+            if (index < spans.size()) {
+                const Span& span = spans[index];
+                if (span.continuation) row += "  ";
+                row.append(text, span.offset, span.length);
+            }
+            if (row.size() > inner) row.resize(inner);
+            if (row == frame[y]) continue;
+            // Дополняем пробелами до рамки, чтобы стереть остаток прежней строки
+            mvwaddnstr(win, y + 1, 1, row.c_str(), static_cast<int>(row.size()));
+            if (row.size() < frame[y].size()) {
+                whline(win, ' ', static_cast<int>(frame[y].size() - row.size()));
+            }
+            frame[y].swap(row);
+        }
+        wattroff(win, COLOR_PAIR(2));
+        wnoutrefresh(win);
     }
+
+private:
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+        bool continuation;
+    };
+
+    std::vector<Span> spans;
+    uint64_t layout_version = UINT64_MAX;
+    int layout_width = -1;
+    std::vector<std::string> frame; // строки, выведенные в прошлый раз
+    std::string drawn_title;
+    std::string row;
 };
 
 // Класс для управления интерфейсом и обновлением данных
 class SystemMonitor {
 public:
-    SystemMonitor() {
-        providers.push_back(std::make_unique<CPUInfoProvider>());
-        providers.push_back(std::make_unique<SystemUsageProvider>());
-        providers.push_back(std::make_unique<TemperaturesProvider>());
-        providers.push_back(std::make_unique<MotherboardProvider>());
-        providers.push_back(std::make_unique<MemoryProvider>());
-        providers.push_back(std::make_unique<DisksProvider>());
-        providers.push_back(std::make_unique<NetworkProvider>());
-        providers.push_back(std::make_unique<GPUProvider>());
-        menu_items = {"CPU", "System Usage", "Temperatures", "Motherboard", "Memory", "Disks", "Network", "GPU"};
+    explicit SystemMonitor(const Options& options) : replay_path(options.replay), agents(options.aggregate) {
+        if (!replay_path.empty() || !agents.empty()) return;
+        make_providers(providers, menu_items, options.interfaces);
+        // Раздел самонаблюдения не входит в меню и открывается клавишей 'i'
+        sections = menu_items;
+        sections.push_back("Monitor");
+        providers.push_back(std::make_unique<MonitorProvider>());
+        monitor_index = static_cast<int>(providers.size()) - 1;
     }
 
-    void run() {
+    int run() {
+        // При воспроизведении разделы берутся из записи, провайдеры не создаются
+        SessionReplay replay;
+        const bool replaying = !replay_path.empty();
+        if (replaying) {
+            std::string error;
+            if (!replay.open(replay_path, error)) {
+                fprintf(stderr, "Error: %s\n", error.c_str());
+                return 1;
+            }
+            sections = menu_items = replay.section_names();
+            if (!menu_items.empty() && menu_items.back() == "Monitor") {
+                menu_items.pop_back();
+                monitor_index = static_cast<int>(menu_items.size());
+            }
+        }
+        // В режиме агрегатора пункт 0 — обзор парка, дальше разделы выбранного хоста
+        std::unique_ptr<FleetAggregator> fleet;
+        const bool aggregating = !agents.empty();
+        if (aggregating) {
+            fleet = std::make_unique<FleetAggregator>(agents);
+            menu_items.assign(1, "Fleet");
+        }
+
         initscr();
         cbreak();
         noecho();
@@ -406,61 +663,126 @@ public:
         init_pair(1, COLOR_CYAN, COLOR_BLACK);
         init_pair(2, COLOR_GREEN, COLOR_BLACK);
         init_pair(3, COLOR_YELLOW, COLOR_BLACK);
-        timeout(3000); // Устанавливаем таймаут 3 секунды
+        timeout(aggregating ? 0 : 200); // Короткий таймаут: новые снимки приходят из фоновых потоков
+        refresh(); // Иначе первый getch() перерисует пустой stdscr поверх окон
+
+        // Опрос идёт в фоне, каждый провайдер со своей периодичностью
+        std::unique_ptr<SamplingScheduler> scheduler;
+        std::unique_ptr<UeventMonitor> uevents;
+        SnapshotSource* source = &replay;
+        if (aggregating) {
+            // Агрегатор ждёт в epoll и сокеты агентов, и клавиатуру, поэтому getch не блокируется
+            fleet->watch_input(STDIN_FILENO);
+            source = fleet.get();
+        } else if (!replaying) {
+            scheduler = std::make_unique<SamplingScheduler>(providers, sections, 4, &history);
+            uevents = std::make_unique<UeventMonitor>(
+                [this, &scheduler](std::string_view subsystem) { on_device_change(providers, *scheduler, subsystem); });
+            source = scheduler.get();
+        }
 
         int max_y, max_x;
         getmaxyx(stdscr, max_y, max_x);
 
-        WINDOW* menu_win = newwin(9, 20, 1, 1);
+        WINDOW* menu_win = newwin(menu_items.size() + 2, 20, 1, 1);
         WINDOW* info_win = newwin(max_y - 11, max_x - 22, 1, 22);
         WINDOW* status_win = newwin(1, max_x, max_y - 1, 0);
 
         int highlight = 0;
+        bool show_monitor = false;
         int scroll_offset = 0;
-        std::string current_info = providers[highlight]->getInfo(); // Инициализация при старте
-
-        auto last_update = std::chrono::steady_clock::now();
+        bool dirty = true;
+        bool content_changed = true;
+        bool status_changed = true;
+        int drawn_highlight = -1;
+        int64_t drawn_second = -1;
+        uint64_t fleet_layout = 0;
+        auto last_frame = std::chrono::steady_clock::now();
+        Snapshot loading;
+        loading.message("Loading...");
 
         while (true) {
             if (is_term_resized(max_y, max_x)) {
                 resize_windows(menu_win, info_win, status_win, max_y, max_x);
+                drawn_highlight = -1;
+                status_changed = content_changed = dirty = true; // Ширина спарклайнов зависит от окна
             }
-
-            display_menu(menu_win, highlight, menu_items);
-
-            wattron(status_win, COLOR_PAIR(3));
-            mvwprintw(status_win, 0, 0, "Use arrows to navigate, Page Up/Down to scroll, q to quit, r to refresh");
-            wattroff(status_win, COLOR_PAIR(3));
-            wrefresh(status_win);
-
-            wattron(info_win, COLOR_PAIR(3));
-            mvwprintw(info_win, 0, 1, "%s Info", menu_items[highlight].c_str());
-            wattroff(info_win, COLOR_PAIR(3));
-            wattron(info_win, COLOR_PAIR(2));
-
-            auto now = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<std::chrono::seconds>(now - last_update).count() >= 3) {
-                current_info = providers[highlight]->getInfo();
-                last_update = now;
+            if (replaying) {
+                auto now = std::chrono::steady_clock::now();
+                replay.advance(std::chrono::duration<double>(now - last_frame).count());
+                last_frame = now;
+                if (replay.position() / 1000 != drawn_second) status_changed = dirty = true;
+            }
+            if (aggregating && fleet->layout_version() != fleet_layout) {
+                // Выбран другой хост или пришло приветствие: меню — его разделы
+                fleet_layout = fleet->layout_version();
+                menu_items.resize(1);
+                menu_items.insert(menu_items.end(), fleet->host_sections().begin(), fleet->host_sections().end());
+                if (highlight >= static_cast<int>(menu_items.size())) highlight = 0;
+                resize_windows(menu_win, info_win, status_win, max_y, max_x);
+                drawn_highlight = -1;
+                content_changed = dirty = true;
+            }
+            const int shown = show_monitor ? monitor_index : highlight;
+            if (source->poll(shown)) {
+                content_changed = dirty = true;
+            }
+            if (dirty) {
+                // Меню и строка состояния перерисовываются только при изменениях
+                if (status_changed) {
+                    draw_status(status_win, replaying ? &replay : nullptr, aggregating);
+                    drawn_second = replay.position() / 1000;
+                    status_changed = false;
+                }
+                if (drawn_highlight != highlight) {
+                    display_menu(menu_win, highlight, menu_items);
+                    drawn_highlight = highlight;
+                }
+                if (content_changed) {
+                    format_snapshot(source->has_sample(shown) ? source->latest(shown) : loading, info_text);
+                    append_history(info_text, history, shown, history_resolution, max_x - 26);
+                    ++content_version;
+                    content_changed = false;
+                }
+                size_t lines = info_renderer.layout(info_text, content_version, max_x - 26);
+                size_t visible = static_cast<size_t>(std::max(0, max_y - 13));
+                scroll_offset = std::min<int>(scroll_offset, static_cast<int>(lines > visible ? lines - visible : 0));
+                std::string title = show_monitor ? "SysInfo Overhead" : menu_items[highlight] + " Info";
+                if (aggregating) title = highlight == 0 ? "Fleet Overview" : fleet->selected_name() + ": " + title;
+                info_renderer.draw(info_win, info_text, title, scroll_offset);
+                doupdate();
+                dirty = false;
             }
 
-            display_info(info_win, current_info, scroll_offset, max_y - 11, max_x - 22);
-            wattroff(info_win, COLOR_PAIR(2));
-
+            if (aggregating) fleet->pump(200);
             int ch = getch();
             if (ch == ERR) {
                 continue;
             }
+            dirty = true;
+            if (replaying && handle_replay_key(replay, ch)) {
+                status_changed = true;
+                continue;
+            }
+            if (aggregating && handle_fleet_key(*fleet, ch, highlight)) {
+                scroll_offset = 0;
+                content_changed = true;
+                continue;
+            }
             switch (ch) {
                 case KEY_UP:
                     highlight = (highlight == 0) ? menu_items.size() - 1 : highlight - 1;
                     scroll_offset = 0;
-                    current_info = providers[highlight]->getInfo(); // Обновление при переключении
+                    show_monitor = false;
+                    source->poll(highlight); // Сразу показываем последний снимок
+                    content_changed = true;
                     break;
                 case KEY_DOWN:
                     highlight = (highlight == menu_items.size() - 1) ? 0 : highlight + 1;
                     scroll_offset = 0;
-                    current_info = providers[highlight]->getInfo(); // Обновление при переключении
+                    show_monitor = false;
+                    source->poll(highlight); // Сразу показываем последний снимок
+                    content_changed = true;
                     break;
                 case KEY_PPAGE:
                     scroll_offset = (scroll_offset > 0) ? scroll_offset - 1 : 0;
@@ -470,8 +792,25 @@ public:
                     break;
                 case 'q':
                     goto cleanup;
+                case 'i':
+                    if (monitor_index < 0) break;
+                    show_monitor = !show_monitor;
+                    scroll_offset = 0;
+                    source->poll(show_monitor ? monitor_index : highlight);
+                    content_changed = true;
+                    break;
                 case 'r':
-                    current_info = providers[highlight]->getInfo(); // Принудительное обновление
+                    if (replaying || aggregating) break;
+                    providers[shown]->invalidate(); // Принудительное обновление, в том числе кэша
+                    scheduler->request(shown);
+                    break;
+                case 'h':
+                    history_resolution = static_cast<HistoryStore::Resolution>((history_resolution + 1) % HistoryStore::kResolutions);
+                    content_changed = true;
+                    break;
+                default:
+                    // Остальные клавиши обрабатывает раздел (например, сортировка процессов)
+                    if (!replaying && !aggregating && providers[shown]->handleKey(ch)) scheduler->request(shown);
                     break;
             }
         }
@@ -481,20 +820,97 @@ public:
         delwin(info_win);
         delwin(status_win);
         endwin();
+        return 0;
     }
 
 private:
+    std::string replay_path;
+    std::vector<std::string> agents;
     std::vector<std::unique_ptr<InfoProvider>> providers;
     std::vector<std::string> menu_items;
+    std::vector<std::string> sections; // пункты меню и скрытый раздел Monitor
+    int monitor_index = -1;
+    std::string info_text;
+    uint64_t content_version = 0;
+    InfoRenderer info_renderer;
+    HistoryStore history;
+    HistoryStore::Resolution history_resolution = HistoryStore::Raw;
+
+    void draw_status(WINDOW* status_win, const SessionReplay* replay, bool aggregating) {
+        werase(status_win);
+        wattron(status_win, COLOR_PAIR(3));
+        if (replay) {
+            // Время воспроизведения, скорость и подсказка по перемотке
+            time_t seconds = replay->position() / 1000;
+            struct tm local;
+            char when[32];
+            localtime_r(&seconds, &local);
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+            mvwprintw(status_win, 0, 0, "Replay %s x%d%s | space pause, f speed, Left/Right 10s, [ ] 1m, { } 1h, Home/End, i overhead, q quit",
+                      when, replay->speed(), replay->paused() ? " paused" : "");
+        } else if (aggregating) {
+            mvwprintw(status_win, 0, 0, "Fleet | n/p select host, Enter open, s sort, arrows navigate, Page Up/Down scroll, r refresh, q quit");
+        } else {
+            mvwprintw(status_win, 0, 0, "Use arrows to navigate, Page Up/Down to scroll, q to quit, r to refresh, h history, s sort, i overhead");
+        }
+        wattroff(status_win, COLOR_PAIR(3));
+        wnoutrefresh(status_win);
+    }
+
+    // Клавиши управления воспроизведением; false — клавиша обрабатывается как обычно
+    static bool handle_replay_key(SessionReplay& replay, int ch) {
+        switch (ch) {
+            case ' ': replay.toggle_pause(); return true;
+            case 'f': replay.faster(); return true;
+            case KEY_LEFT: replay.seek(replay.position() - 10 * 1000); return true;
+            case KEY_RIGHT: replay.seek(replay.position() + 10 * 1000); return true;
+            case '[': replay.seek(replay.position() - 60 * 1000); return true;
+            case ']': replay.seek(replay.position() + 60 * 1000); return true;
+            case '{': replay.seek(replay.position() - 3600 * 1000); return true;
+            case '}': replay.seek(replay.position() + 3600 * 1000); return true;
+            case KEY_HOME: replay.seek(replay.begin()); return true;
+            case KEY_END: replay.seek(replay.end()); return true;
+        }
+        return false;
+    }
+
+    // Клавиши агрегатора; false — клавиша обрабатывается как обычно
+    static bool handle_fleet_key(FleetAggregator& fleet, int ch, int& highlight) {
+        switch (ch) {
+            case 'n': fleet.select_next(1); return true;
+            case 'p': fleet.select_next(-1); return true;
+            case '\n':
+            case KEY_ENTER:
+                if (highlight == 0 && !fleet.host_sections().empty()) highlight = 1;
+                return true;
+            case KEY_UP:
+            case KEY_DOWN:
+            case KEY_PPAGE:
+            case KEY_NPAGE:
+            case 'q':
+            case 'h':
+                return false;
+        }
+        // Остальные клавиши обзор понимает сам ('s'), а в разделах хоста их обрабатывает агент
+        if (highlight == 0) {
+            if (ch == 's') fleet.cycle_sort();
+        } else {
+            fleet.send_key(highlight - 1, ch);
+        }
+        return true;
+    }
 
     void resize_windows(WINDOW*& menu_win, WINDOW*& info_win, WINDOW*& status_win, int& max_y, int& max_x) {
         getmaxyx(stdscr, max_y, max_x);
-        wresize(menu_win, std::min(9, max_y - 2), 20);
+        wresize(menu_win, std::min<int>(menu_items.size() + 2, max_y - 2), 20);
         wresize(info_win, max_y - 11, max_x - 22);
         wresize(status_win, 1, max_x);
         mvwin(menu_win, 1, 1);
         mvwin(info_win, 1, 22);
         mvwin(status_win, max_y - 1, 0);
+        werase(menu_win);
+        clearok(curscr, TRUE);
+        info_renderer.invalidate();
     }
 
     void display_menu(WINDOW* menu_win, int highlight, const std::vector<std::string>& items) {
@@ -504,32 +920,20 @@ private:
             mvwprintw(menu_win, i + 1, 2, "%s", items[i].c_str());
             wattroff(menu_win, A_REVERSE | COLOR_PAIR(1));
         }
-        wrefresh(menu_win);
-    }
-
-    void display_info(WINDOW* info_win, const std::string& info, int scroll_offset, int max_lines, int max_cols) {
-        werase(info_win);
-        box(info_win, 0, 0);
-        std::istringstream iss(info);
-        std::string line;
-        std::vector<std::string> lines;
-        while (std::getline(iss, line)) {
-            while (line.length() > max_cols - 4) {
-                lines.push_back(line.substr(0, max_cols - 4));
-                line = "  " + line.substr(max_cols - 4);
-            }
-            lines.push_back(line);
-        }
-        int y = 1;
-        for (int i = scroll_offset; i < lines.size() && y < max_lines - 2; ++i) {
-            mvwprintw(info_win, y++, 1, "%s", lines[i].c_str());
-        }
-        wrefresh(info_win);
+        wnoutrefresh(menu_win);
     }
 };
 
-int main() {
-    SystemMonitor monitor;
-    monitor.run();
-    return 0;
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return argc > 1 && std::string_view(argv[1]) == "--help" ? 0 : 2;
+    }
+    if (options.headless) {
+        HeadlessExporter exporter(options);
+        return exporter.run();
+    }
+    SystemMonitor monitor(options);
+    return monitor.run();
 }
@@ -0,0 +1,2089 @@
+#pragma once
+
+// Сбор данных SysInfo: снимки, провайдеры, планировщик опроса и форматирование.
+// Реализация провайдеров — в providers.cpp, запуск команд — в command.cpp, планировщик — в scheduler.cpp,
+// запись и воспроизведение — в recording.cpp, агент и агрегатор — в fleet.cpp.
+// Интерфейс ncurses и режим без интерфейса находятся в sysinfo.cpp, бенчмарки — в bench/
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <sys/wait.h>
+#include <signal.h>
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <string_view>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <cctype>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <fnmatch.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <pwd.h>
+
+// Гистограмма задержек в духе HDR: 32 линейные подкорзины на каждую степень двойки
+// (погрешность не больше 3%), наносекунды до ~18 минут. Запись — несколько relaxed-атомиков
+// без блокировок, поэтому измерение почти не влияет на измеряемое; читать можно из любого потока
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr int kMaxBits = 40;
+    static constexpr size_t kBuckets = static_cast<size_t>(kMaxBits - kSubBits + 1) << kSubBits;
+
+    void record(uint64_t ns) {
+        ns = std::min<uint64_t>(ns, (1ull << kMaxBits) - 1);
+        counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t previous = maximum.load(std::memory_order_relaxed);
+        while (ns > previous && !maximum.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? static_cast<double>(sum.load(std::memory_order_relaxed)) / count() : 0.0; }
+
+    // Верхняя граница корзины, в которую попадает доля q отсчётов
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * n)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= target) return std::min(bucket_high(i), max());
+        }
+        return max();
+    }
+
+private:
+    std::atomic<uint64_t> counts[kBuckets] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static size_t bucket(uint64_t value) {
+        int bits = value ? 64 - __builtin_clzll(value) : 0;
+        int shift = std::max(0, bits - kSubBits - 1);
+        return (static_cast<size_t>(shift) << kSubBits) + (value >> shift);
+    }
+
+    static uint64_t bucket_high(size_t index) {
+        if (index < (2u << kSubBits)) return index;
+        int shift = static_cast<int>(index >> kSubBits) - 1;
+        uint64_t sub = (index & ((1u << kSubBits) - 1)) + (1u << kSubBits);
+        return ((sub + 1) << shift) - 1;
+    }
+};
+
+// Самонаблюдение монитора: задержки провайдеров и внешних команд, запуски процессов,
+// таймауты и прочитанные байты. Записи создаются один раз и живут до конца процесса
+class SelfStats {
+public:
+    struct Provider {
+        explicit Provider(std::string_view name) : name(name) {}
+        const std::string name;
+        LatencyHistogram latency;
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> bytes_read{0};
+    };
+
+    struct Command {
+        explicit Command(std::string_view name) : name(name) {}
+        const std::string name;
+        LatencyHistogram latency;
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> output_bytes{0};
+    };
+
+    // Счётчики текущего потока: планировщик по их приращению узнаёт долю одного опроса
+    inline static thread_local uint64_t thread_bytes_read = 0;
+    inline static thread_local uint64_t thread_commands = 0;
+
+    static SelfStats& instance() {
+        static SelfStats stats;
+        return stats;
+    }
+
+    Provider& provider(std::string_view name) { return find_or_add(providers, name); }
+    Command& command(std::string_view name) { return find_or_add(commands, name); }
+
+    // Доступ по номеру для отображения; записи не перемещаются, ссылки остаются действительными
+    size_t provider_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return providers.size();
+    }
+    Provider& provider_at(size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return providers[index];
+    }
+    size_t command_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return commands.size();
+    }
+    Command& command_at(size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return commands[index];
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<Provider> providers;
+    std::deque<Command> commands;
+
+    template <typename T>
+    T& find_or_add(std::deque<T>& entries, std::string_view name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (T& entry : entries) {
+            if (entry.name == name) return entry;
+        }
+        return entries.emplace_back(name);
+    }
+};
+
+// Результат выполнения внешней команды
+struct CommandResult {
+    std::string output;
+    int exit_status = -1;
+    bool timed_out = false;
+    bool truncated = false; // вывод длиннее CommandRunner::kMaxOutput обрезан
+    bool failed = false;    // не удалось создать канал или процесс
+};
+
+// Запускает команду через /bin/sh в отдельной группе процессов; stdout и stderr идут в канал,
+// конец которого для чтения неблокирующий. Возвращает false, если не удалось создать канал или процесс
+bool spawn_command(const char* cmd, pid_t& pid, int& out_fd);
+
+// Имя утилиты для статистики: первое слово команды без каталога
+inline std::string_view utility_name(std::string_view cmd) {
+    cmd = cmd.substr(0, cmd.find(' '));
+    size_t slash = cmd.rfind('/');
+    return slash == std::string_view::npos ? cmd : cmd.substr(slash + 1);
+}
+
+// Запуск дочерних процессов без опроса со sleep: неблокирующие каналы, poll и pidfd.
+// Несколько команд выполняются одновременно, общее время равно времени самой медленной.
+class CommandRunner {
+public:
+    // Сколько процессов запущено с начала работы; используется бенчмарком
+    inline static std::atomic<uint64_t> spawned{0};
+
+    // Предел сохраняемого вывода одной команды; остаток читается и отбрасывается
+    static constexpr size_t kMaxOutput = 1 << 20;
+
+    CommandRunner() = default;
+    CommandRunner(const CommandRunner&) = delete;
+    CommandRunner& operator=(const CommandRunner&) = delete;
+
+    ~CommandRunner();
+
+    // Запускает команду через /bin/sh и возвращает её индекс
+    size_t start(const char* cmd, int timeout_ms);
+
+    // Ждёт завершения всех запущенных команд или истечения их сроков
+    void wait_all();
+
+    CommandResult& result(size_t index) { return children[index].result; }
+
+private:
+    struct Child {
+        pid_t pid = -1;
+        int out_fd = -1;
+        int pid_fd = -1;
+        bool done = false;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point deadline;
+        SelfStats::Command* stats = nullptr;
+        CommandResult result;
+    };
+
+    std::vector<Child> children;
+
+    // Читает всё доступное из канала; буфер растёт по мере необходимости
+    void drain(Child& child);
+
+    // Забирает статус завершения; после выхода процесса дочитывает остаток вывода
+    void reap(Child& child, int flags);
+
+    void kill_child(Child& child);
+
+    void finish(Child& child);
+};
+
+// Долгоживущая команда с построчным выводом (nvidia-smi --loop-ms): процесс запускается один раз,
+// готовые строки забираются из неблокирующего канала без ожидания, неполная строка ждёт продолжения
+class CommandStream {
+public:
+    CommandStream() = default;
+    CommandStream(const CommandStream&) = delete;
+    CommandStream& operator=(const CommandStream&) = delete;
+    ~CommandStream() { stop(); }
+
+    bool start(const char* cmd);
+
+    bool running() const { return pid > 0; }
+
+    // Передаёт on_line все завершённые строки; false, если команда закончила работу
+    template <typename F>
+    bool read_lines(F&& on_line) {
+        if (pid <= 0) return false;
+        bool eof = false;
+        char buf[4096];
+        while (true) {
+            ssize_t count = ::read(out_fd, buf, sizeof(buf));
+            if (count > 0) {
+                pending.append(buf, count);
+                stats->output_bytes.fetch_add(count, std::memory_order_relaxed);
+                SelfStats::thread_bytes_read += count;
+                continue;
+            }
+            if (count < 0 && errno == EINTR) continue;
+            eof = count == 0 || errno != EAGAIN;
+            break;
+        }
+        size_t begin = 0;
+        for (size_t eol; (eol = pending.find('\n', begin)) != std::string::npos; begin = eol + 1) {
+            on_line(std::string_view(pending).substr(begin, eol - begin));
+        }
+        pending.erase(0, begin);
+        if (eof) stop();
+        return !eof;
+    }
+
+    void stop();
+
+private:
+    pid_t pid = -1;
+    int out_fd = -1;
+    std::string pending;
+    std::chrono::steady_clock::time_point started;
+    SelfStats::Command* stats = nullptr;
+};
+
+// Приводит результат команды к тексту; пустой вывод считается ошибкой
+std::string command_output(const CommandResult& result);
+
+// Утилитная функция для выполнения команд
+std::string exec_command(const char* cmd, int timeout_seconds = 5);
+
+// Утилитная функция для проверки наличия утилиты
+bool is_utility_installed(const std::string& util);
+
+// Файл sysfs/procfs, открытый один раз и перечитываемый через pread без повторного open
+class PreadFile {
+public:
+    PreadFile() = default;
+    explicit PreadFile(const std::string& path) { open(path); }
+    PreadFile(PreadFile&& other) noexcept : fd(other.fd) { other.fd = -1; }
+    PreadFile& operator=(PreadFile&& other) noexcept {
+        std::swap(fd, other.fd);
+        return *this;
+    }
+    PreadFile(const PreadFile&) = delete;
+    PreadFile& operator=(const PreadFile&) = delete;
+    ~PreadFile() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool open(const std::string& path) {
+        if (fd >= 0) close(fd);
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        return fd >= 0;
+    }
+
+    bool is_open() const { return fd >= 0; }
+
+    // Читает файл с начала в buf и завершает его нулём; возвращает длину или -1
+    ssize_t read(char* buf, size_t size) const {
+        if (fd < 0 || size == 0) return -1;
+        ssize_t count = pread(fd, buf, size - 1, 0);
+        if (count < 0) return -1;
+        buf[count] = '\0';
+        SelfStats::thread_bytes_read += count;
+        return count;
+    }
+
+    // Читает файл целиком в buf, увеличивая его при необходимости. Файлы /proc вроде diskstats
+    // отдаются записями, поэтому читаем до конца, а не до первого неполного блока
+    ssize_t read(std::vector<char>& buf) const {
+        if (fd < 0) return -1;
+        if (buf.size() < 4096) buf.resize(4096);
+        size_t length = 0;
+        while (true) {
+            if (buf.size() - length < 1024) buf.resize(buf.size() * 2);
+            ssize_t count = pread(fd, buf.data() + length, buf.size() - length - 1, length);
+            if (count < 0) return -1;
+            if (count == 0) break;
+            length += count;
+        }
+        buf[length] = '\0';
+        SelfStats::thread_bytes_read += length;
+        return length;
+    }
+
+    // Для /proc/self/mountinfo: ядро сообщает об изменении таблицы монтирования через POLLPRI
+    bool poll_changed() const {
+        pollfd entry{fd, POLLPRI, 0};
+        return fd >= 0 && ::poll(&entry, 1, 0) > 0 && (entry.revents & (POLLPRI | POLLERR));
+    }
+
+    // Для файлов с одним числом вроде scaling_cur_freq
+    bool read_u64(uint64_t& value) const {
+        char buf[32];
+        ssize_t count = read(buf, sizeof(buf));
+        return count > 0 && std::from_chars(buf, buf + count, value).ec == std::errc();
+    }
+
+private:
+    int fd = -1;
+};
+
+// Разбор чисел без локали и выделений памяти; ведущие пробелы пропускаются, p сдвигается за число
+inline bool parse_u64(const char*& p, const char* end, uint64_t& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    auto [next, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc()) return false;
+    p = next;
+    return true;
+}
+
+// Следующая строка из text без перевода строки; false, когда текст закончился
+inline bool next_line(std::string_view& text, std::string_view& line) {
+    if (text.empty()) return false;
+    size_t eol = text.find('\n');
+    line = text.substr(0, eol);
+    text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+    return true;
+}
+
+// Горячий файл /proc: постоянный дескриптор и буфер фиксированного размера внутри объекта.
+// Для single_open-файлов вроде /proc/stat усечённое чтение отдаёт начало файла, которого достаточно
+template <size_t Size>
+class ProcFile {
+public:
+    bool open(const std::string& path) { return file.open(path); }
+    bool is_open() const { return file.is_open(); }
+
+    // Перечитывает файл с начала; пустой view при ошибке
+    std::string_view read() {
+        ssize_t count = file.read(buffer.data(), buffer.size());
+        return count < 0 ? std::string_view() : std::string_view(buffer.data(), count);
+    }
+
+private:
+    PreadFile file;
+    std::array<char, Size> buffer;
+};
+
+// /proc/meminfo по таблице ключей; значения хранятся в байтах
+class MeminfoReader {
+public:
+    // HugePages_* — числа страниц, а не килобайты; их значения отдаёт count()
+    enum Key {
+        MemTotal, MemFree, MemAvailable, Buffers, Cached, SwapTotal, SwapFree,
+        Shmem, Slab, SReclaimable, SUnreclaim, KernelStack, PageTables, AnonHugePages, ShmemHugePages,
+        HugePagesTotal, HugePagesFree, HugePagesRsvd, HugePagesSurp, Hugepagesize, kKeys
+    };
+
+    explicit MeminfoReader(const std::string& root = "") { file.open(root + "/proc/meminfo"); }
+
+    bool update();
+
+    double bytes(Key key) const { return static_cast<double>(values[key]) * 1024.0; }
+    double count(Key key) const { return static_cast<double>(values[key]); }
+
+private:
+    static constexpr std::string_view kNames[kKeys] = {
+        "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "SwapTotal", "SwapFree",
+        "Shmem", "Slab", "SReclaimable", "SUnreclaim", "KernelStack", "PageTables", "AnonHugePages", "ShmemHugePages",
+        "HugePages_Total", "HugePages_Free", "HugePages_Rsvd", "HugePages_Surp", "Hugepagesize"};
+    ProcFile<8192> file;
+    uint64_t values[kKeys] = {};
+};
+
+// Читает небольшой текстовый файл целиком, без завершающего перевода строки
+std::string read_text_file(const std::string& path);
+
+// Название устройства PCI по базе pci.ids ("NVIDIA Corporation GA102 [GeForce RTX 3080]");
+// без базы — числовые коды
+std::string pci_device_name(uint32_t vendor, uint32_t device);
+
+// Разбирает список процессоров в формате sysfs: "0-3,8,10-11"
+std::vector<int> parse_cpu_list(const std::string& list);
+
+// Скорость монотонного счётчика за интервал; после сброса (значение меньше прошлого) отсчёт идёт от нуля
+double counter_rate(uint64_t previous, uint64_t current, double elapsed);
+
+// Единицы измерения числовых полей; значения хранятся в исходных единицах источника
+enum class Unit : uint8_t {
+    None,
+    Count,
+    Percent,
+    Bytes,
+    BytesPerSecond,
+    PerSecond,
+    KiloHertz,
+    MilliCelsius,
+    Rpm,
+    MicroWatts,
+    Milliseconds,
+    Microseconds,
+};
+
+// Вид поля снимка
+enum class FieldKind : uint8_t {
+    Number,    // число с единицей измерения
+    Text,      // строка из буфера снимка
+    Heading,   // заголовок группы
+    Separator, // разделитель между группами
+};
+
+// Флаги раскладки поля; применяются только при отрисовке
+enum FieldFlags : uint8_t {
+    kFieldInline = 1 << 0,  // продолжает строку предыдущего поля
+    kFieldNoLabel = 1 << 1, // выводится только значение
+    kFieldHeat = 1 << 2,    // процент рисуется одним символом тепловой карты
+    kFieldHistory = 1 << 3, // значение сохраняется в истории и рисуется спарклайном
+    kFieldRowKey = 1 << 4,  // текст-ключ строки таблицы (cpu3, sda, eth0) для следующих полей строки
+};
+
+// Реестр имён метрик: имя интернируется один раз, в полях хранится только его номер
+class MetricNames {
+public:
+    static MetricNames& instance() {
+        static MetricNames names;
+        return names;
+    }
+
+    uint32_t intern(std::string_view name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(names.size());
+        names.emplace_back(name);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    // Ссылки стабильны: элементы deque не перемещаются при добавлении в конец
+    const std::string& name(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return names[id];
+    }
+
+private:
+    MetricNames() { names.emplace_back(); ids.emplace(names.back(), 0); } // 0 — поле без имени
+
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::map<std::string, uint32_t, std::less<>> ids;
+};
+
+inline uint32_t metric_name(std::string_view name) { return MetricNames::instance().intern(name); }
+
+// Плоская запись снимка: 16 байт на поле, текст лежит в общем буфере снимка
+struct Field {
+    struct TextRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    uint32_t name = 0;
+    Unit unit = Unit::None;
+    FieldKind kind = FieldKind::Number;
+    uint8_t flags = 0;
+    uint8_t width = 0; // минимальная ширина ячейки при отрисовке
+    union {
+        double number;
+        TextRef text;
+    } value{0.0};
+};
+
+// Снимок провайдера. Провайдер заполняет его на месте; clear() сохраняет ёмкость,
+// поэтому в установившемся режиме опрос не выделяет память
+class Snapshot {
+public:
+    void clear() {
+        fields.clear();
+        arena.clear();
+    }
+
+    void number(uint32_t name, double value, Unit unit, uint8_t flags = 0, uint8_t width = 0) {
+        Field& field = fields.emplace_back();
+        field.name = name;
+        field.unit = unit;
+        field.kind = FieldKind::Number;
+        field.flags = flags;
+        field.width = width;
+        field.value.number = value;
+    }
+
+    void text(uint32_t name, std::string_view value, uint8_t flags = 0, uint8_t width = 0) {
+        push_text(FieldKind::Text, name, value, flags, width);
+    }
+
+    // Строка без имени: сообщения об ошибках и вывод утилит
+    void message(std::string_view value) { push_text(FieldKind::Text, 0, value, 0, 0); }
+
+    void heading(std::string_view value) { push_text(FieldKind::Heading, 0, value, 0, 0); }
+
+    void separator() {
+        Field& field = fields.emplace_back();
+        field.kind = FieldKind::Separator;
+    }
+
+    // Копирует поля другого снимка, например закэшированную статическую часть
+    void append(const Snapshot& other) {
+        uint32_t base = static_cast<uint32_t>(arena.size());
+        arena.append(other.arena);
+        for (Field field : other.fields) {
+            if (field.kind != FieldKind::Number && field.kind != FieldKind::Separator) field.value.text.offset += base;
+            fields.push_back(field);
+        }
+    }
+
+    // Меняет значение числового поля; воспроизведение записи накладывает столбцы на схему
+    void set_number(size_t index, double value) { fields[index].value.number = value; }
+
+    // Меняет текст поля; прежний текст остаётся в буфере до clear
+    void set_text(size_t index, std::string_view value) {
+        fields[index].value.text = {static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(value.size())};
+        arena.append(value);
+    }
+
+    const std::vector<Field>& items() const { return fields; }
+    bool empty() const { return fields.empty(); }
+
+    std::string_view text_of(const Field& field) const {
+        return std::string_view(arena.data() + field.value.text.offset, field.value.text.length);
+    }
+
+private:
+    std::vector<Field> fields;
+    std::string arena;
+
+    void push_text(FieldKind kind, uint32_t name, std::string_view value, uint8_t flags, uint8_t width) {
+        Field& field = fields.emplace_back();
+        field.name = name;
+        field.kind = kind;
+        field.flags = flags;
+        field.width = width;
+        field.value.text = {static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(value.size())};
+        arena.append(value);
+    }
+};
+
+// Строки вида "Ключ: значение" становятся именованными текстовыми полями, остальные — сообщениями
+void append_key_value_line(Snapshot& out, std::string_view line);
+
+// Построчно переносит многострочный текст в снимок
+void append_lines(Snapshot& out, std::string_view text);
+
+// Примитивы двоичной записи в порядке байтов машины: файлы и кадры читает тот же тип хоста
+template <typename T>
+void put_raw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get_raw(std::string_view& in, T& value) {
+    if (in.size() < sizeof(value)) return false;
+    memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    return true;
+}
+
+void put_string(std::string& out, std::string_view text);
+
+bool get_string(std::string_view& in, std::string_view& text);
+
+// Двоичная запись снимка. Имена сохраняются строками: их номера действительны только внутри процесса
+void serialize_snapshot(std::string& out, const Snapshot& snapshot);
+
+// Дописывает поля из двоичной записи в снимок; false — запись повреждена
+bool deserialize_snapshot(std::string_view& in, Snapshot& out);
+
+// Кэш аппаратной конфигурации (dmidecode) на диске. Записи действительны
+// до перезагрузки (ключ — boot_id) или до события udev в связанной подсистеме
+class InventoryCache {
+public:
+    static InventoryCache& instance();
+
+    // Дописывает закэшированные поля в out; false — записи нет
+    bool get(std::string_view key, Snapshot& out);
+
+    void put(std::string_view key, std::string_view subsystem, const Snapshot& snapshot);
+
+    void invalidate(std::string_view key);
+
+    // Сбрасывает все записи, зависящие от подсистемы udev (pci, block, memory...)
+    void invalidate_subsystem(std::string_view subsystem);
+
+private:
+    struct Entry {
+        std::string subsystem;
+        std::string data;
+        uint32_t uid = 0; // кто собрал запись: данные root (серийные номера DMI) другим не выдаются
+    };
+
+    static constexpr char kMagic[8] = {'S', 'I', 'I', 'N', 'V', '0', '0', '2'};
+
+    std::mutex mutex;
+    std::map<std::string, Entry, std::less<>> entries;
+    std::string path;
+    std::string boot_id;
+
+    InventoryCache();
+
+    void load();
+
+    // Запись во временный файл с правами 0600 и rename, чтобы параллельный запуск не прочитал половину файла
+    void save();
+};
+
+// Слушает события ядра (NETLINK_KOBJECT_UEVENT) и сообщает подсистему изменившегося устройства
+class UeventMonitor {
+public:
+    explicit UeventMonitor(std::function<void(std::string_view)> on_change);
+
+    ~UeventMonitor();
+
+private:
+    std::function<void(std::string_view)> on_change;
+    int sock = -1;
+    int wake[2] = {-1, -1};
+    std::thread thread;
+
+    void loop();
+};
+
+// Базовый класс для провайдеров информации
+class InfoProvider {
+public:
+    // Заполняет уже очищенный снимок; форматирование в текст делает только интерфейс
+    virtual void sample(Snapshot& out) = 0;
+    // Период опроса; ноль означает, что данные читаются один раз
+    virtual std::chrono::milliseconds refreshInterval() const { return std::chrono::seconds(3); }
+    // Зависит ли вывод от устройств подсистемы udev (pci, block, memory...)
+    virtual bool dependsOn(std::string_view /*subsystem*/) const { return false; }
+    // Ручное обновление: сбросить закэшированные данные
+    virtual void invalidate() {}
+    // Клавиша, не занятая интерфейсом; true, если вид раздела изменился
+    virtual bool handleKey(int /*key*/) { return false; }
+    virtual ~InfoProvider() {}
+};
+
+// Провайдер для CPU: топология читается из sysfs один раз, при обновлении перечитываются
+// только текущие частоты ядер через заранее открытые дескрипторы
+class CPUInfoProvider : public InfoProvider {
+public:
+    explicit CPUInfoProvider(std::string root = "") : root(std::move(root)) {}
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(1); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    std::string root;
+    bool topology_loaded = false;
+    std::vector<int> cpus;
+    Snapshot topology;
+    std::vector<PreadFile> freq_files;
+    std::vector<std::string> freq_labels;
+    std::vector<uint64_t> freq_khz;
+
+    std::string cpu_dir(int cpu) const;
+
+    void load_topology();
+
+    std::string cpu_model_name() const;
+
+    // Кэши: уровень, тип, размер и число экземпляров (уникальных shared_cpu_list)
+    void append_cache_info();
+
+    void append_numa_info();
+};
+
+// Загрузка процессоров по /proc/stat. Счётчики хранятся структурой массивов:
+// строка 0 — суммарная "cpu", далее cpuN; разности и проценты считаются одним проходом
+class CpuLoadEngine {
+public:
+    enum Column { User, Nice, System, Idle, IoWait, Irq, SoftIrq, Steal, kColumns };
+    // Доли, которые показываются пользователю; nice входит в user
+    enum Share { ShareUser, ShareSystem, ShareIoWait, ShareIrq, ShareSoftIrq, ShareSteal, ShareBusy, kShares };
+
+    bool update(const std::string& path);
+
+    size_t rows() const { return ids.size(); }
+    int cpu_id(size_t row) const { return ids[row]; }
+    float share(Share share, size_t row) const { return shares[share][row]; }
+
+private:
+    std::vector<int> ids;
+    std::vector<uint64_t> current[kColumns];
+    std::vector<uint64_t> previous[kColumns];
+    std::vector<float> shares[kShares];
+    // Строк cpu хватает примерно на 800 процессоров; строка intr в конце может обрезаться
+    ProcFile<64 * 1024> stat_file;
+
+    // Счётчик iowait может уменьшаться, поэтому отрицательные разности обнуляются
+    static inline uint64_t delta(uint64_t now, uint64_t before) { return now > before ? now - before : 0; }
+
+    void compute();
+};
+
+// Провайдер для System Usage
+class SystemUsageProvider : public InfoProvider {
+public:
+    explicit SystemUsageProvider(const std::string& root = "")
+        : stat_path(root + "/proc/stat"), root_path(root.empty() ? "/" : root), meminfo(root) {}
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(1); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    static constexpr size_t kHeatRow = 32;
+
+    // Пути собраны заранее, чтобы опрос не выделял память
+    std::string stat_path;
+    std::string root_path;
+    CpuLoadEngine cpu_load;
+    MeminfoReader meminfo;
+    std::vector<std::string> core_labels;
+
+    void ensure_core_labels(size_t cores);
+};
+
+// Провайдер для Temperatures: датчики hwmon и thermal обнаруживаются один раз при первом опросе,
+// дальше каждый вход перечитывается через pread в фиксированный буфер
+class TemperaturesProvider : public InfoProvider {
+public:
+    explicit TemperaturesProvider(std::string root = "") : root(std::move(root)) {}
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    // Значения хранятся в единицах sysfs: миллиградусы, об/мин, микроватты
+    struct Sensor {
+        Unit unit;
+        std::string chip;
+        uint32_t name = 0;
+        PreadFile input;
+        int64_t max = 0;
+        int64_t crit = 0;
+    };
+
+    std::string root;
+    bool discovered = false;
+    std::vector<Sensor> sensors;
+
+    static int64_t read_threshold(const std::string& path);
+
+    // Каталоги с числовым суффиксом в естественном порядке: hwmon2 раньше hwmon10
+    static std::vector<std::string> list_dirs(const std::string& dir, const std::string& prefix);
+
+    void discover();
+
+    void discover_hwmon(const std::string& dir);
+
+    void discover_thermal_zone(const std::string& dir);
+};
+
+// Провайдер для Motherboard
+class MotherboardProvider : public InfoProvider {
+public:
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::milliseconds(0); }
+
+    void invalidate() override { InventoryCache::instance().invalidate(kCacheKey); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    static constexpr const char* kCacheKey = "dmidecode.baseboard";
+};
+
+// Провайдер для Memory
+class MemoryProvider : public InfoProvider {
+public:
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::milliseconds(0); }
+
+    bool dependsOn(std::string_view subsystem) const override { return subsystem == "memory"; }
+
+    void invalidate() override { InventoryCache::instance().invalidate(kCacheKey); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    static constexpr const char* kCacheKey = "dmidecode.memory";
+};
+
+// Провайдер для Pressure: PSI из /proc/pressure, узлы NUMA, скорости событий /proc/vmstat,
+// огромные страницы и slab. Файлы открыты постоянно, скорости считаются по разнице между опросами
+class PressureProvider : public InfoProvider {
+public:
+    explicit PressureProvider(const std::string& root = "");
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    bool dependsOn(std::string_view subsystem) const override { return subsystem == "memory"; }
+
+    void invalidate() override { nodes_valid = false; }
+
+    void sample(Snapshot& out) override;
+
+private:
+    // Счётчики vmstat; allocstall_* (по зонам в новых ядрах) складываются в прямой reclaim
+    enum Event { PageFaults, MajorFaults, SwapIn, SwapOut, CompactionStalls, ReclaimStalls, kEvents };
+    enum NodeKey { NodeTotal, NodeFree, NodeFile, NodeAnon, kNodeKeys };
+
+    struct Psi {
+        const char* name = "";
+        ProcFile<256> file;
+        uint64_t some_total = 0;
+        uint64_t full_total = 0;
+    };
+
+    struct Node {
+        std::string name;
+        ProcFile<4096> meminfo;
+        ProcFile<1024> numastat;
+        uint64_t previous_misses = 0;
+    };
+
+    std::string root;
+    MeminfoReader meminfo;
+    Psi psi[3];
+    ProcFile<16384> vmstat;
+    std::deque<Node> nodes;
+    std::atomic<bool> nodes_valid{false};
+    uint64_t previous_events[kEvents] = {};
+    std::chrono::steady_clock::time_point previous_time;
+
+    void discover_nodes();
+
+    // "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456"
+    static bool parse_psi_line(std::string_view line, double avg[3], uint64_t& total);
+
+    void read_vmstat(uint64_t events[kEvents], uint64_t& oom_kills);
+
+    // "Node 0 MemTotal:       16303388 kB"
+    static bool read_node_meminfo(Node& node, uint64_t values[kNodeKeys]);
+
+    static uint64_t read_numa_miss(Node& node);
+};
+
+// Провайдер для Disks: устройства из /sys/block, скорости по /proc/diskstats и заполненность
+// смонтированных файловых систем. Дескрипторы и буферы живут между опросами
+class DisksProvider : public InfoProvider {
+public:
+    explicit DisksProvider(std::string root = "") : root(std::move(root)) {}
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    bool dependsOn(std::string_view subsystem) const override { return subsystem == "block"; }
+
+    // Состав устройств перечитывается при следующем опросе
+    void invalidate() override { topology_valid = false; }
+
+    void sample(Snapshot& out) override;
+
+private:
+    // Счётчики /proc/diskstats, которые нужны для скоростей; сектор в diskstats всегда 512 байт
+    enum Counter { Reads, SectorsRead, ReadTicks, Writes, SectorsWritten, WriteTicks, IoTicks, QueueTicks, kCounters };
+
+    struct Device {
+        std::string name;
+        std::string label; // модель диска или имя device-mapper
+        bool mapper = false;
+        double size = 0;
+        unsigned partitions = 0;
+        bool present = false; // устройство нашлось в последнем чтении diskstats
+        bool sampled = false; // в previous лежат данные прошлого опроса
+        uint64_t previous[kCounters] = {};
+        uint64_t current[kCounters] = {};
+    };
+
+    // Устройство или раздел по номеру major:minor
+    struct Location {
+        size_t device;
+        bool partition;
+        std::string name;
+    };
+
+    struct Mount {
+        std::string point;
+        std::string source;
+    };
+
+    std::string root;
+    std::atomic<bool> topology_valid{false};
+    std::vector<Device> devices;
+    std::unordered_map<uint64_t, Location> numbers;
+    PreadFile diskstats;
+    size_t diskstats_lines = 0;
+    std::chrono::steady_clock::time_point last_read;
+    bool has_previous = false;
+    PreadFile mountinfo;
+    std::vector<Mount> mounts;
+    std::vector<char> buffer;
+
+    static uint64_t device_number(unsigned long major, unsigned long minor) { return (uint64_t(major) << 32) | minor; }
+
+    // Разбирает содержимое файла dev вида "259:0"
+    static bool parse_device_number(const std::string& text, uint64_t& number);
+
+    // Перечитывает /sys/block; разделы находятся по файлу partition в подкаталогах устройства
+    void discover();
+
+    // Обновляет current у известных устройств; возвращает секунды с прошлого чтения или 0
+    double read_counters();
+
+    // Таблица монтирования перечитывается только когда ядро сообщает о её изменении
+    void update_mounts();
+
+    // В mountinfo пробелы и спецсимволы записаны как \040
+    static std::string unescape(std::string_view text);
+
+    void sample_mounts(Snapshot& out);
+};
+
+// Фильтр сетевых интерфейсов по шаблонам fnmatch; при пустом include подходят все
+struct InterfaceFilter {
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+
+    bool matches(const char* name) const;
+};
+
+// Провайдер для Network: состояние и 64-битные счётчики всех интерфейсов одним дампом
+// RTM_GETLINK через постоянный сокет rtnetlink, без запуска ip
+class NetworkProvider : public InfoProvider {
+public:
+    explicit NetworkProvider(InterfaceFilter filter = {}, std::string root = "")
+        : filter(std::move(filter)), root(std::move(root)) {}
+
+    ~NetworkProvider() override;
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(1); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    enum Counter { RxBytes, TxBytes, RxPackets, TxPackets, RxErrors, TxErrors, RxDropped, TxDropped, kCounters };
+
+    struct Interface {
+        int index = 0;
+        std::string name;
+        uint8_t oper_state = 0;
+        uint64_t generation = 0; // номер дампа, в котором интерфейс встречался последним
+        bool sampled = false;
+        uint64_t previous[kCounters] = {};
+        uint64_t current[kCounters] = {};
+    };
+
+    InterfaceFilter filter;
+    std::string root;
+    int fd = -1;
+    uint32_t sequence = 0;
+    uint64_t generation = 0;
+    std::vector<char> buffer;
+    std::vector<Interface> interfaces;
+    std::unordered_map<int, size_t> slots; // ifindex -> позиция в interfaces
+    std::chrono::steady_clock::time_point last_dump;
+
+    bool open_socket();
+
+    // Запрашивает дамп всех интерфейсов и обновляет таблицу; elapsed — секунды с прошлого дампа
+    bool dump_links(double& elapsed);
+
+    // После ошибки сокет пересоздаётся на следующем опросе
+    bool reset();
+
+    void parse_link(nlmsghdr* header);
+
+    // Адаптеры из /sys/class/bluetooth и блокировки из /sys/class/rfkill вместо bluetoothctl
+    const char* bluetooth_state() const;
+};
+
+// Провайдер для GPU. Адаптеры находятся один раз по /sys/bus/pci (класс 0x03) и /sys/class/drm;
+// загрузка, видеопамять, частоты, температура и мощность amdgpu и i915 читаются из sysfs через
+// открытые заранее дескрипторы. Для NVIDIA работает один долгоживущий nvidia-smi --loop-ms,
+// его CSV разбирается по мере поступления строк
+class GPUProvider : public InfoProvider {
+public:
+    explicit GPUProvider(std::string root = "") : root(std::move(root)) {}
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    bool dependsOn(std::string_view subsystem) const override { return subsystem == "pci" || subsystem == "drm"; }
+
+    void invalidate() override { devices_valid = false; }
+
+    void sample(Snapshot& out) override;
+
+private:
+    static constexpr uint32_t kVendorAmd = 0x1002;
+    static constexpr uint32_t kVendorIntel = 0x8086;
+    static constexpr uint32_t kVendorNvidia = 0x10de;
+    static constexpr auto kRestartDelay = std::chrono::seconds(30);
+
+    struct Gpu {
+        std::string slot; // адрес PCI: 0000:03:00.0
+        std::string driver;
+        std::string model;
+        uint32_t vendor = 0;
+        PreadFile busy;                  // amdgpu: gpu_busy_percent
+        PreadFile vram_used, vram_total; // amdgpu: mem_info_vram_*
+        PreadFile sclk, mclk;            // amdgpu: pp_dpm_*, текущий уровень отмечен '*'
+        PreadFile cur_freq, max_freq;    // i915: gt_cur_freq_mhz, gt_max_freq_mhz
+        PreadFile rc6;                   // i915: power/rc6_residency_ms
+        PreadFile temp, power;           // hwmon: temp1_input, power1_average
+        uint64_t previous_rc6 = 0;
+        std::chrono::steady_clock::time_point previous_time;
+    };
+
+    // Столбцы запроса nvidia-smi после index, pci.bus_id, name и driver_version
+    enum NvidiaColumn { NvMemTotal, NvMemUsed, NvUtil, NvTemp, NvClock, NvPower, kNvidiaColumns };
+
+    struct NvidiaSample {
+        std::string bus; // последние семь символов адреса в нижнем регистре: "01:00.0"
+        std::string name;
+        std::string driver;
+        double values[kNvidiaColumns];
+    };
+
+    std::string root;
+    std::atomic<bool> devices_valid{false};
+    std::deque<Gpu> gpus; // PreadFile не копируется; deque не перемещает элементы
+    CommandStream nvidia_smi;
+    std::vector<NvidiaSample> nvidia_rows;
+    std::chrono::steady_clock::time_point nvidia_restart;
+    bool nvidia_missing = false;
+
+    void discover();
+
+    // Строки вида "0: 300Mhz" и "1: 1800Mhz *"
+    static bool read_dpm_level(const PreadFile& file, uint64_t& mhz);
+
+    // Забирает новые строки nvidia-smi; упавший процесс перезапускается не чаще раза в 30 секунд
+    // или сразу после ручного обновления
+    void read_nvidia();
+
+    // "0, 00000000:01:00.0, NVIDIA GeForce RTX 3080, 550.54, 10240, 1234, 7, 45, 210, 25.31";
+    // неподдерживаемые значения приходят как "[N/A]" и становятся NaN
+    void parse_nvidia_line(std::string_view line);
+
+    NvidiaSample* find_nvidia(std::string_view slot);
+
+    const char* nvidia_status() const;
+};
+
+// Постоянные вспомогательные потоки для разбора больших списков: создаются при первой нужде
+// и живут вместе с владельцем. Байты, прочитанные помощниками, засчитываются вызвавшему потоку,
+// а через него — провайдеру в SelfStats
+class RangeWorkers {
+public:
+    RangeWorkers() = default;
+    RangeWorkers(const RangeWorkers&) = delete;
+    RangeWorkers& operator=(const RangeWorkers&) = delete;
+
+    ~RangeWorkers();
+
+    // Делит [0, count) на parts частей и вызывает fn(begin, end) для каждой; часть 0 выполняет вызывающий поток
+    void run(size_t count, size_t parts, const std::function<void(size_t, size_t)>& fn);
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::vector<std::thread> threads;
+    const std::function<void(size_t, size_t)>* task = nullptr;
+    size_t task_count = 0;
+    size_t task_step = 0;
+    size_t active = 0;
+    size_t pending = 0;
+    uint64_t round = 0;
+    uint64_t helper_bytes = 0;
+    bool stopping = false;
+
+    void loop(size_t index);
+};
+
+// Провайдер для Processes: таблица процессов в духе top. Каталог /proc открыт постоянно,
+// файлы процессов читаются через openat, прошлые счётчики хранятся в таблице по PID.
+// Большие списки PID разбираются параллельно, командная строка читается только для новых процессов
+class ProcessesProvider : public InfoProvider {
+public:
+    enum SortKey { SortCpu, SortMemory, SortPid, SortThreads, kSortKeys };
+
+    explicit ProcessesProvider(std::string root = "") : root(std::move(root)) {}
+
+    ~ProcessesProvider() override;
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    bool handleKey(int key) override;
+
+    void sample(Snapshot& out) override;
+
+private:
+    static constexpr size_t kMaxRows = 200;
+    static constexpr size_t kParallelChunk = 2048; // меньше этого числа PID на поток не выгодно
+
+    struct Process {
+        int pid = 0;
+        bool live = false;
+        bool fresh = false;           // слот занят в этом опросе, прошлых счётчиков нет
+        uint64_t generation = 0;      // номер опроса, в котором PID встречался последним
+        uint64_t start_time = 0;      // отличает повторно выданный PID
+        uint64_t ticks = 0;           // utime + stime
+        uint64_t previous_ticks = 0;
+        double cpu = 0;
+        double rss = 0;
+        uint32_t threads = 0;
+        char state = '?';
+        std::string command;
+    };
+
+    std::string root;
+    int proc_fd = -1;
+    std::atomic<int> sort_key{SortCpu};
+    uint64_t generation = 0;
+    std::vector<char> dirents;
+    std::vector<int> pids;
+    std::vector<uint32_t> pid_slots; // слот для pids[i]
+    std::vector<Process> rows;
+    std::vector<uint32_t> free_slots;
+    std::unordered_map<int, uint32_t> slots;
+    std::vector<uint32_t> order;
+    std::chrono::steady_clock::time_point last_scan;
+    const long clock_ticks = sysconf(_SC_CLK_TCK);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    RangeWorkers helpers;
+
+    // Числовые записи /proc через getdents64 в переиспользуемый буфер
+    bool list_pids();
+
+    // Обновляет таблицу; возвращает секунды с прошлого опроса или 0 для первого
+    double scan();
+
+    void read_range(size_t begin, size_t end, double elapsed);
+
+    ssize_t read_at(const char* path, char* buf, size_t size) const;
+
+    // pid (comm) state ppid ... utime(14) stime(15) ... num_threads(20) ... starttime(22) vsize(23) rss(24)
+    bool parse_stat(const char* buf, Process& process, double elapsed);
+
+    // Аргументы разделены нулями; у потоков ядра cmdline пуст, показываем [comm]
+    void read_command(Process& process, std::string_view comm);
+};
+
+// Провайдер для Cgroups: дерево cgroup v2 с потреблением CPU, памяти и ввода-вывода каждой группы.
+// Дерево обходится один раз, дальше создание и удаление групп отслеживается через inotify.
+// Счётчики cgroup v2 уже включают потомков, поэтому свёрнутая ветка показывает итог всего поддерева.
+// Постоянные дескрипторы на каждый файл при тысячах контейнеров упёрлись бы в лимит открытых файлов,
+// поэтому, как и в Processes, файлы читаются через openat от дескриптора корня
+class CgroupsProvider : public InfoProvider {
+public:
+    enum SortKey { SortCpu, SortMemory, SortIo, kSortKeys };
+
+    explicit CgroupsProvider(std::string root = "") : root(std::move(root)) {}
+
+    ~CgroupsProvider() override;
+
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    void invalidate() override { tree_valid = false; }
+
+    // 's' — порядок сортировки, 'c' — глубина раскрытия дерева
+    bool handleKey(int key) override;
+
+    void sample(Snapshot& out) override;
+
+private:
+    static constexpr size_t kMaxRows = 300;
+    static constexpr int kMaxDepth = 6;
+
+    struct Group {
+        std::string path; // относительно корня иерархии, у корня пустой
+        uint32_t parent = 0;
+        int depth = 0;
+        int watch = -1;
+        bool live = false;
+        uint64_t sampled = 0; // номер опроса, в котором группа читалась последний раз
+        uint64_t usage_usec = 0;
+        uint64_t read_bytes = 0;
+        uint64_t write_bytes = 0;
+        double cpu = 0;
+        double memory = 0;
+        double read_rate = 0;
+        double write_rate = 0;
+    };
+
+    std::string root;
+    int root_fd = -1;
+    int inotify_fd = -1;
+    std::string mount; // каталог иерархии cgroup v2
+    std::atomic<bool> tree_valid{false};
+    std::atomic<int> sort_key{SortCpu};
+    std::atomic<int> depth_limit{2};
+    std::vector<Group> groups;       // слот 0 — корень
+    std::vector<uint32_t> free_slots;
+    std::unordered_map<std::string, uint32_t> by_path;
+    std::unordered_map<int, uint32_t> by_watch;
+    std::vector<std::vector<uint32_t>> children;
+    std::vector<uint32_t> stack;
+    std::vector<char> events;
+    std::string row;
+    std::chrono::steady_clock::time_point last_scan;
+    uint64_t generation = 0;
+
+    // Полный обход: при запуске, по 'r' и после переполнения очереди inotify
+    bool rescan();
+
+    // Добавляет группу и всё её поддерево; каталог ставится под наблюдение до чтения,
+    // чтобы не пропустить группы, созданные во время обхода
+    void add_tree(const std::string& path, uint32_t parent, int depth);
+
+    void remove_tree(const std::string& path);
+
+    void release(uint32_t index);
+
+    void read_events();
+
+    void build_children();
+
+    size_t subtree_size(uint32_t index) const;
+
+    ssize_t read_file(const Group& group, const char* file, char* buf, size_t size) const;
+
+    // usage_usec из cpu.stat, memory.current и сумма rbytes/wbytes по устройствам из io.stat.
+    // Скорости считаются, только если группа читалась и в прошлом опросе: у свёрнутой ветки
+    // счётчики устарели, и после раскрытия первый опрос лишь задаёт новую точку отсчёта
+    void update_usage(Group& group, double elapsed);
+
+    static uint64_t stat_value(std::string_view line, std::string_view key);
+
+    // false для "max" и у корня, где memory.max нет
+    bool read_limit(const Group& group, uint64_t& limit) const;
+
+    // avg10 строки "some" файла *.pressure
+    double read_pressure(const Group& group, const char* file) const;
+};
+
+// Провайдер для Monitor: во что обходится сам монитор. Время CPU, RSS и потоки берутся
+// из /proc/self/stat, задержки опросов и внешних команд — из гистограмм SelfStats
+class MonitorProvider : public InfoProvider {
+public:
+    std::chrono::milliseconds refreshInterval() const override { return std::chrono::seconds(2); }
+
+    void sample(Snapshot& out) override;
+
+private:
+    ProcFile<1024> stat_file;
+    uint64_t previous_ticks = 0;
+    std::chrono::steady_clock::time_point last_sample;
+    const long clock_ticks = sysconf(_SC_CLK_TCK);
+    const long page_size = sysconf(_SC_PAGESIZE);
+
+    static void append_latency(Snapshot& out, const LatencyHistogram& latency, uint32_t p50, uint32_t p90, uint32_t p99, uint32_t max);
+
+    // После "(comm) " идут поля с 3-го: utime(14) stime(15) num_threads(20) rss(24).
+    // Приоритет может быть отрицательным, поэтому ненужные поля только пропускаются
+    static bool parse_stat(std::string_view text, uint64_t& ticks, uint64_t& threads, uint64_t& rss_pages);
+};
+
+// Кольцевой буфер фиксированной ёмкости: добавление O(1), память выделяется один раз
+template <typename T, size_t N>
+class RingBuffer {
+public:
+    void push(const T& value) {
+        items[head] = value;
+        head = (head + 1) % N;
+        if (count < N) ++count;
+    }
+
+    size_t size() const { return count; }
+    static constexpr size_t capacity() { return N; }
+
+    // i = 0 — самый старый элемент
+    const T& at(size_t i) const { return items[(head + N - count + i) % N]; }
+
+private:
+    std::array<T, N> items{};
+    size_t head = 0;
+    size_t count = 0;
+};
+
+// История метрик: для каждой отмеченной kFieldHistory метрики хранятся сырые отсчёты
+// и агрегаты min/avg/max за 1 и 15 минут. Объём памяти ограничен числом рядов.
+class HistoryStore {
+public:
+    enum Resolution { Raw, Minute, QuarterHour, kResolutions };
+
+    struct Rollup {
+        float min = 0, avg = 0, max = 0;
+    };
+
+    static constexpr size_t kMaxSeries = 256;
+
+    HistoryStore() : origin(std::chrono::steady_clock::now()) {}
+
+    // Добавляет отмеченные поля снимка провайдера в историю
+    void record(size_t provider, const Snapshot& snapshot);
+
+    // Ряды провайдера в порядке появления
+    void series_of(size_t provider, std::vector<size_t>& out);
+
+    // Копирует последние max_points точек ряда (для агрегатов — средние) и min/max окна
+    size_t read(size_t index, Resolution resolution, float* values, size_t max_points, Rollup& window, uint32_t& name, Unit& unit);
+
+private:
+    // Накопитель агрегата за текущий интервал
+    struct Accumulator {
+        int64_t bucket = -1;
+        float min = 0, max = 0;
+        double sum = 0;
+        uint32_t count = 0;
+
+        void add(float low, float mean, float high, uint32_t weight) {
+            if (count == 0) {
+                min = low;
+                max = high;
+            } else {
+                min = std::min(min, low);
+                max = std::max(max, high);
+            }
+            sum += static_cast<double>(mean) * weight;
+            count += weight;
+        }
+
+        Rollup take() {
+            Rollup rollup{min, static_cast<float>(sum / count), max};
+            count = 0;
+            sum = 0;
+            return rollup;
+        }
+    };
+
+    struct Series {
+        size_t provider;
+        uint32_t name;
+        uint32_t occurrence;
+        Unit unit;
+        RingBuffer<float, 600> raw;         // 10 минут при опросе раз в секунду
+        RingBuffer<Rollup, 1440> minute;    // сутки
+        RingBuffer<Rollup, 672> quarter;    // неделя
+        Accumulator minute_acc;
+        Accumulator quarter_acc;
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Series>> series;
+    std::vector<std::pair<uint32_t, uint32_t>> occurrences;
+
+    Series* find_or_create(size_t provider, uint32_t name, uint32_t occurrence, Unit unit);
+
+    static void append(Series& s, float value, int64_t seconds);
+};
+
+// Последнее значение без блокировок: тройной буфер для одного писателя и одного читателя.
+// Писатель заполняет back() на месте и вызывает publish(), читатель забирает свежий буфер через update().
+template <typename T>
+class LatestValue {
+public:
+    T& back() { return slots[back_index]; }
+
+    void publish() {
+        uint8_t prev = middle.exchange(back_index | kFresh, std::memory_order_acq_rel);
+        back_index = prev & kIndexMask;
+    }
+
+    // Возвращает true, если с прошлого вызова появилось новое значение
+    bool update() {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) return false;
+        uint8_t prev = middle.exchange(front_index, std::memory_order_acq_rel);
+        front_index = prev & kIndexMask;
+        return true;
+    }
+
+    const T& front() const { return slots[front_index]; }
+
+private:
+    static constexpr uint8_t kFresh = 0x4;
+    static constexpr uint8_t kIndexMask = 0x3;
+
+    T slots[3];
+    std::atomic<uint8_t> middle{1};
+    uint8_t back_index = 0;  // принадлежит писателю
+    uint8_t front_index = 2; // принадлежит читателю
+};
+
+// Источник снимков для интерфейса: живой опрос или воспроизведение записи
+class SnapshotSource {
+public:
+    // Забирает свежий снимок раздела; true, если он изменился
+    virtual bool poll(size_t index) = 0;
+    virtual bool has_sample(size_t index) const = 0;
+    virtual const Snapshot& latest(size_t index) const = 0;
+    virtual ~SnapshotSource() {}
+};
+
+// Планировщик опроса: рабочие потоки вызывают провайдеры с их собственной периодичностью,
+// а интерфейс читает готовые снимки без ожидания
+class SamplingScheduler : public SnapshotSource {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    SamplingScheduler(const std::vector<std::unique_ptr<InfoProvider>>& providers, const std::vector<std::string>& names,
+                      size_t worker_count, HistoryStore* history = nullptr);
+
+    ~SamplingScheduler();
+
+    // Внеочередное обновление провайдера (клавиша 'r')
+    void request(size_t index);
+
+    // Забирает свежий снимок провайдера; вызывается только из потока интерфейса
+    bool poll(size_t index) override;
+
+    bool has_sample(size_t index) const override { return entries[index].has_sample; }
+
+    const Snapshot& latest(size_t index) const override { return entries[index].slot.front(); }
+
+private:
+    struct Entry {
+        InfoProvider* provider = nullptr;
+        SelfStats::Provider* stats = nullptr;
+        LatestValue<Snapshot> slot;
+        Clock::time_point due = Clock::now();
+        bool busy = false;
+        bool pending = false;
+        bool has_sample = false; // только для потока интерфейса
+    };
+
+    std::vector<Entry> entries;
+    HistoryStore* history;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+
+    void worker_loop();
+};
+
+// Беззнаковые целые переменной длины (LEB128) и zigzag для знаковых приращений
+inline void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline bool get_varint(std::string_view& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+inline int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+// Числа в записи хранятся целыми с точностью, которой достаточно для отображения
+inline double record_scale(Unit unit) {
+    switch (unit) {
+        case Unit::Percent:
+        case Unit::PerSecond: return 10.0;
+        case Unit::Milliseconds:
+        case Unit::None: return 100.0;
+        case Unit::Microseconds: return 10.0;
+        default: return 1.0;
+    }
+}
+
+// Формат файла записи (--record). Заголовок: "SIREC002", смещение последнего индексного блока
+// (перезаписывается через pwrite), имена разделов. Далее блоки [тип u8][длина u32][данные]:
+//   'S' схема раздела — полный снимок; пишется, когда меняется структура снимка или текст заголовков;
+//   'B' до 64 отсчётов раздела: времена приращениями, числовые поля столбцами. Столбец хранится
+//       либо как отклонения от минимума, либо как приращения — что короче, упакованными по битам.
+//       За ними словарь блока — строки текстовых полей, отличные от схемы, — и по столбцу номеров
+//       на каждое текстовое поле: 0 — текст схемы, k — k-я строка словаря;
+//   'I' индекс: времена и смещения блоков 'B' с прошлого индекса и ссылка на прошлый индекс;
+//   'D' пропуск: раздел, время первого и последнего отсчёта и их число, не записанные из-за лимита схем
+namespace record_format {
+constexpr char kMagic[8] = {'S', 'I', 'R', 'E', 'C', '0', '0', '2'};
+constexpr size_t kIndexOffsetPos = 8;
+constexpr size_t kChunkHeader = 5;
+constexpr size_t kBlockTicks = 64;
+constexpr size_t kBlocksPerIndex = 64;
+}
+
+class SessionRecorder {
+public:
+    SessionRecorder() = default;
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+    ~SessionRecorder() { close(); }
+
+    bool open(const std::string& path, const std::vector<std::string>& names);
+
+    bool ok() const { return fd >= 0 && !failed; }
+
+    void append(size_t index, const Snapshot& snapshot, int64_t time_ms);
+
+    // Дописывает незавершённые блоки и индекс; после этого файл читается целиком
+    void close();
+
+private:
+    static constexpr double kSchemaBytesPerSecond = 128;
+    static constexpr double kSchemaBurst = 256 * 1024;
+
+    struct Section {
+        Snapshot schema;
+        uint64_t schema_offset = 0;
+        int64_t refill_time = 0; // последнее пополнение бюджета схем
+        double budget = kSchemaBurst;
+        uint64_t dropped = 0;    // отсчёты, пропущенные после последней записанной схемы
+        int64_t dropped_first = 0;
+        int64_t dropped_last = 0;
+        std::vector<size_t> numeric; // номера числовых полей схемы
+        std::vector<double> scales;
+        std::vector<size_t> texts;   // номера текстовых полей схемы
+        std::vector<int64_t> times;
+        std::vector<std::vector<int64_t>> columns;
+        std::vector<std::vector<int64_t>> text_columns;
+        std::vector<std::string> strings; // словарь текущего блока
+        std::unordered_map<std::string, int64_t> string_ids;
+    };
+
+    struct IndexEntry {
+        uint64_t section;
+        int64_t first;
+        int64_t last;
+        uint64_t offset;
+    };
+
+    int fd = -1;
+    bool failed = false;
+    uint64_t size = 0;
+    uint64_t last_index = 0;
+    std::vector<Section> sections;
+    std::vector<IndexEntry> pending;
+    std::string scratch;
+    std::string payload;
+    std::vector<uint64_t> packed;
+
+    static bool same_shape(const Snapshot& a, const Snapshot& b);
+
+    static void set_schema(Section& section, const Snapshot& snapshot);
+
+    // Номер текста поля в словаре блока; 0 — текст совпадает со схемой
+    static int64_t string_id(Section& section, std::string_view schema_text, std::string_view text);
+
+    bool write_at(const std::string& data, uint64_t offset);
+
+    uint64_t write_chunk(char type, const std::string& data);
+
+    void write_dropped(size_t index);
+
+    void flush_block(size_t index);
+
+    static int bit_width(uint64_t range) { return range ? 64 - __builtin_clzll(range) : 0; }
+
+    // Выбирает меньшее из двух представлений столбца и пакует его по битам
+    void encode_column(const std::vector<int64_t>& column);
+
+    void pack_bits(const std::vector<uint64_t>& values, int width);
+
+    void write_index();
+};
+
+// Воспроизведение записи (--replay): файл отображается в память, индекс собирается по цепочке
+// индексных блоков, раздел на момент времени восстанавливается из одного блока 'B' и его схемы
+class SessionReplay : public SnapshotSource {
+public:
+    SessionReplay() = default;
+    SessionReplay(const SessionReplay&) = delete;
+    SessionReplay& operator=(const SessionReplay&) = delete;
+    ~SessionReplay();
+
+    bool open(const std::string& path, std::string& error);
+
+    const std::vector<std::string>& section_names() const { return names; }
+    int64_t position() const { return position_ms; }
+    int64_t begin() const { return first_time; }
+    int64_t end() const { return last_time; }
+    bool paused() const { return is_paused; }
+    int speed() const { return kSpeeds[speed_index]; }
+
+    void toggle_pause() { is_paused = !is_paused; }
+    void faster() { speed_index = (speed_index + 1) % (sizeof(kSpeeds) / sizeof(kSpeeds[0])); }
+    void seek(int64_t time_ms) { position_ms = std::clamp(time_ms, first_time, last_time); }
+
+    // Продвигает время воспроизведения на прошедшее реальное время с учётом скорости
+    void advance(double seconds);
+
+    bool poll(size_t index) override;
+
+    bool has_sample(size_t index) const override { return sections[index].has_sample; }
+
+    const Snapshot& latest(size_t index) const override { return sections[index].current; }
+
+private:
+    static constexpr int kSpeeds[] = {1, 4, 16, 64, 256};
+
+    struct Block {
+        int64_t first;
+        int64_t last;
+        uint64_t offset;
+    };
+
+    struct Section {
+        std::vector<Block> blocks;
+        size_t decoded_block = SIZE_MAX;
+        uint64_t schema_offset = 0;
+        Snapshot schema;
+        std::vector<size_t> numeric;
+        std::vector<double> scales;
+        std::vector<size_t> texts;
+        std::vector<int64_t> times;
+        std::vector<std::vector<int64_t>> columns;
+        std::vector<std::vector<int64_t>> text_columns;
+        std::vector<std::string_view> strings; // словарь блока указывает в отображённый файл
+        size_t tick = 0;
+        bool has_sample = false;
+        Snapshot current;
+    };
+
+    const char* data = nullptr;
+    size_t length = 0;
+    std::vector<std::string> names;
+    std::vector<Section> sections;
+    int64_t first_time = std::numeric_limits<int64_t>::max();
+    int64_t last_time = std::numeric_limits<int64_t>::min();
+    int64_t position_ms = 0;
+    bool is_paused = false;
+    size_t speed_index = 0;
+
+    // Блок по смещению: тип и данные; false, если он выходит за конец файла (запись оборвалась)
+    bool chunk_at(uint64_t offset, char& type, std::string_view& payload) const;
+
+    void add_block(uint64_t section, int64_t first, int64_t last, uint64_t offset);
+
+    // Индексные блоки связаны в цепочку от последнего; блоки после него (запись прервана
+    // до очередного индекса) находятся последовательным проходом по заголовкам
+    void load_index(uint64_t last_index, uint64_t data_start);
+
+    bool load_schema(Section& section, uint64_t offset);
+
+    bool decode(Section& section, size_t block);
+
+    static bool decode_column(std::string_view& in, size_t n, std::vector<int64_t>& column);
+};
+
+// Адрес сокета: "HOST:PORT", ":PORT" (127.0.0.1), "[::1]:PORT" или "unix:PATH"; имя хоста разрешается через DNS
+bool parse_socket_address(const std::string& address, sockaddr_storage& storage, socklen_t& length);
+
+// Протокол агента (--agent) и агрегатора (--aggregate): поток кадров [длина u32][тип u8][данные],
+// длина не включает свои 4 байта. Агент -> агрегатор:
+//   'H' приветствие: версия протокола, имя хоста, имена разделов;
+//   'N' новые имена метрик: номер в процессе агента и строка; каждое имя идёт в соединение один раз;
+//   'S' снимок раздела: номер раздела и поля; целые числа передаются zigzag varint, текст — длиной и байтами.
+// Агрегатор -> агент:
+//   'W' подписка: имена разделов, "*" — все; до подписки агент шлёт только приветствие;
+//   'K' клавиша для раздела (сортировка процессов, глубина cgroup), 'r' — принудительный опрос
+namespace fleet_format {
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeader = 5;
+constexpr uint32_t kMaxFrame = 16 << 20;
+constexpr uint8_t kIntegerValue = 0x80; // в байте вида поля: число передано как varint
+constexpr uint32_t kUnknownName = UINT32_MAX;
+
+enum class FrameStatus { Ready, Partial, Corrupt };
+
+inline size_t begin_frame(std::string& out, char type) {
+    size_t start = out.size();
+    put_raw<uint32_t>(out, 0);
+    out += type;
+    return start;
+}
+
+inline void end_frame(std::string& out, size_t start) {
+    uint32_t length = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    memcpy(&out[start], &length, sizeof(length));
+}
+
+// Отделяет следующий кадр от начала буфера; данные кадра остаются в буфере получателя
+inline FrameStatus next_frame(std::string_view& in, char& type, std::string_view& payload) {
+    uint32_t length;
+    if (in.size() < sizeof(length)) return FrameStatus::Partial;
+    memcpy(&length, in.data(), sizeof(length));
+    if (length == 0 || length > kMaxFrame) return FrameStatus::Corrupt;
+    if (in.size() - sizeof(length) < length) return FrameStatus::Partial;
+    type = in[sizeof(length)];
+    payload = in.substr(kHeader, length - 1);
+    in.remove_prefix(sizeof(length) + length);
+    return FrameStatus::Ready;
+}
+
+// Поля снимка с номерами имён отправителя
+inline void put_fields(std::string& out, const Snapshot& snapshot) {
+    put_varint(out, snapshot.items().size());
+    for (const Field& field : snapshot.items()) {
+        const double value = field.value.number;
+        const bool integer = field.kind == FieldKind::Number && std::fabs(value) < 9.0e15 && value == std::trunc(value);
+        put_varint(out, field.name);
+        out += static_cast<char>(static_cast<uint8_t>(field.kind) | (integer ? kIntegerValue : 0));
+        out += static_cast<char>(field.unit);
+        out += static_cast<char>(field.flags);
+        out += static_cast<char>(field.width);
+        if (integer) {
+            put_varint(out, zigzag(static_cast<int64_t>(value)));
+        } else if (field.kind == FieldKind::Number) {
+            put_raw(out, value);
+        } else if (field.kind != FieldKind::Separator) {
+            std::string_view text = snapshot.text_of(field);
+            put_varint(out, text.size());
+            out.append(text);
+        }
+    }
+}
+
+// Дописывает поля в out; names переводит номера имён отправителя в местные. false — кадр повреждён
+inline bool get_fields(std::string_view& in, const std::vector<uint32_t>& names, Snapshot& out) {
+    uint64_t count;
+    if (!get_varint(in, count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t remote, length;
+        if (!get_varint(in, remote) || remote >= names.size() || names[remote] == kUnknownName || in.size() < 4) return false;
+        const uint32_t name = names[remote];
+        const uint8_t kind = static_cast<uint8_t>(in[0]);
+        const Unit unit = static_cast<Unit>(in[1]);
+        const uint8_t flags = static_cast<uint8_t>(in[2]);
+        const uint8_t width = static_cast<uint8_t>(in[3]);
+        in.remove_prefix(4);
+        if (static_cast<uint8_t>(unit) > static_cast<uint8_t>(Unit::Microseconds)) return false;
+        switch (kind) {
+            case static_cast<uint8_t>(FieldKind::Number) | kIntegerValue: {
+                uint64_t value;
+                if (!get_varint(in, value)) return false;
+                out.number(name, static_cast<double>(unzigzag(value)), unit, flags, width);
+                break;
+            }
+            case static_cast<uint8_t>(FieldKind::Number): {
+                double value;
+                if (!get_raw(in, value)) return false;
+                out.number(name, value, unit, flags, width);
+                break;
+            }
+            case static_cast<uint8_t>(FieldKind::Text):
+            case static_cast<uint8_t>(FieldKind::Heading):
+                if (!get_varint(in, length) || length > in.size()) return false;
+                if (kind == static_cast<uint8_t>(FieldKind::Text)) out.text(name, in.substr(0, length), flags, width);
+                else out.heading(in.substr(0, length));
+                in.remove_prefix(length);
+                break;
+            case static_cast<uint8_t>(FieldKind::Separator):
+                out.separator();
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+}
+
+// Сторона агента: принятые соединения получают снимки разделов, на которые подписались.
+// Снимок кодируется один раз на все соединения; медленный получатель пропускает снимки, а не копит их
+class FleetPublisher {
+public:
+    struct KeyRequest {
+        size_t section;
+        int key;
+    };
+
+    FleetPublisher(std::vector<std::string> sections, std::string host) : sections(std::move(sections)), host(std::move(host)) {}
+    FleetPublisher(const FleetPublisher&) = delete;
+    FleetPublisher& operator=(const FleetPublisher&) = delete;
+    ~FleetPublisher();
+
+    // Новое соединение сразу получает приветствие
+    void add_peer(int fd);
+
+    void publish(size_t section, const Snapshot& snapshot);
+
+    size_t peer_count() const { return peers.size(); }
+
+    // Дописывает сокеты соединений; события передаются в service в том же порядке
+    void add_pollfds(std::vector<pollfd>& fds) const;
+
+    // Читает подписки и клавиши, дописывает отложенный вывод; latest — последние снимки для новых подписчиков
+    void service(const pollfd* fds, const std::vector<const Snapshot*>& latest, std::vector<KeyRequest>& keys);
+
+private:
+    struct Peer {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        size_t sent = 0;
+        std::vector<bool> subscribed;
+        std::vector<bool> names_sent; // по номеру имени в MetricNames
+    };
+
+    static constexpr size_t kMaxPeers = 64;
+    static constexpr size_t kMaxBacklog = 4 << 20;
+
+    std::vector<std::string> sections;
+    std::string host;
+    std::vector<Peer> peers;
+    std::string frame;
+
+    void encode(size_t section, const Snapshot& snapshot);
+
+    // Новые имена полей уходят отдельным кадром перед снимком, который на них ссылается
+    void send_sample(Peer& peer, const Snapshot& snapshot);
+
+    // false — соединение закрыто или сломано
+    bool flush(Peer& peer);
+
+    bool receive(Peer& peer, const std::vector<const Snapshot*>& latest, std::vector<KeyRequest>& keys);
+};
+
+// Разрешение адресов агентов вне цикла epoll: отдельный поток вызывает getaddrinfo и будит цикл
+// через eventfd. Очередь общая с потоком, поэтому при выходе поток отсоединяется и медленный DNS
+// не задерживает завершение
+class AddressResolver {
+public:
+    struct Result {
+        size_t id;
+        bool ok;
+        sockaddr_storage storage;
+        socklen_t length;
+    };
+
+    AddressResolver();
+
+    AddressResolver(const AddressResolver&) = delete;
+    AddressResolver& operator=(const AddressResolver&) = delete;
+
+    ~AddressResolver();
+
+    // Становится читаемым, когда есть готовые результаты
+    int fd() const { return state->event_fd; }
+
+    void request(size_t id, const std::string& address);
+
+    void collect(std::vector<Result>& out);
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::pair<size_t, std::string>> queue;
+        std::vector<Result> done;
+        bool stopping = false;
+        int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        ~State() {
+            if (event_fd >= 0) close(event_fd);
+        }
+    };
+
+    std::shared_ptr<State> state;
+
+    static void loop(std::shared_ptr<State> state);
+};
+
+// Сторона агрегатора (--aggregate): один поток с epoll держит соединения со всеми агентами.
+// Кадры разбираются прямо в буфере приёма соединения, в снимки копируются только сами поля.
+// Раздел 0 — обзор парка, разделы 1..N — разделы выбранного хоста. Остальные хосты подписаны
+// только на System Usage и Temperatures, поэтому сотни агентов обходятся в единицы КиБ/с каждый
+class FleetAggregator : public SnapshotSource {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum SortKey { SortCpu, SortMemory, SortTemperature, SortName, kSortKeys };
+
+    explicit FleetAggregator(const std::vector<std::string>& addresses);
+
+    FleetAggregator(const FleetAggregator&) = delete;
+    FleetAggregator& operator=(const FleetAggregator&) = delete;
+
+    ~FleetAggregator();
+
+    // Ввод с клавиатуры прерывает ожидание в pump
+    void watch_input(int fd);
+
+    // Ждёт событий не дольше timeout_ms, разбирает пришедшие кадры и переподключает агентов
+    void pump(int timeout_ms);
+
+    bool poll(size_t index) override;
+
+    bool has_sample(size_t index) const override;
+
+    const Snapshot& latest(size_t index) const override;
+
+    // Разделы выбранного хоста из его приветствия; номер меняется при выборе другого хоста или новом приветствии
+    const std::vector<std::string>& host_sections() const { return hosts[selected].sections; }
+    const std::string& selected_name() const { return hosts[selected].name; }
+    uint64_t layout_version() const { return layout; }
+
+    // Выбор соседнего хоста в порядке сортировки обзора
+    void select_next(int step);
+
+    void cycle_sort();
+
+    // Клавиша уходит агенту выбранного хоста: раздел 0 меню — обзор, поэтому номер раздела на 1 меньше
+    void send_key(size_t section, int key);
+
+private:
+    struct Host {
+        enum State { Waiting, Connecting, Connected };
+
+        std::string address;
+        std::string name;
+        State state = Waiting;
+        int fd = -1;
+        Clock::time_point retry{};      // следующая попытка подключения
+        Clock::time_point last_frame{}; // последний кадр или начало подключения
+        std::chrono::milliseconds backoff = kInitialBackoff;
+        std::string error;
+        bool resolving = false; // адрес разрешается в потоке AddressResolver
+        bool resolved = false;  // storage годен; сбрасывается при обрыве, чтобы заметить смену адреса
+        sockaddr_storage storage{};
+        socklen_t storage_length = 0;
+        std::vector<char> buffer; // приём: целые кадры разбираются на месте, остаток сдвигается в начало
+        size_t filled = 0;
+        std::vector<uint32_t> names; // номер имени в агенте -> местный
+        std::vector<std::string> sections;
+        std::vector<Snapshot> snapshots;
+        std::vector<bool> present;
+        std::vector<bool> fresh;
+        int usage_section = -1;
+        int temperature_section = -1;
+        double cpu = NAN;
+        double memory = NAN;
+        double temperature = NAN;
+    };
+
+    static constexpr uint64_t kInputTag = UINT64_MAX;
+    static constexpr uint64_t kResolverTag = UINT64_MAX - 1;
+    static constexpr size_t kMaxNames = 64 * 1024; // имён у агента на порядки меньше
+    static constexpr size_t kReadChunk = 64 * 1024;
+    static constexpr std::chrono::milliseconds kInitialBackoff{1000};
+    static constexpr std::chrono::milliseconds kMaxBackoff{30000};
+    static constexpr std::chrono::milliseconds kConnectTimeout{5000};
+    static constexpr std::chrono::milliseconds kStaleAfter{15000};
+
+    std::vector<Host> hosts;
+    std::vector<size_t> order; // хосты в порядке строк обзора
+    size_t selected = 0;
+    SortKey sort_key = SortCpu;
+    uint64_t layout = 0;
+    int epoll_fd;
+    std::vector<epoll_event> events;
+    Snapshot overview;
+    bool overview_dirty = true;
+    Clock::time_point overview_time{};
+    uint64_t bytes_received = 0;
+    uint64_t frames_received = 0;
+    uint64_t rate_bytes = 0;
+    uint64_t rate_frames = 0;
+    Clock::time_point rate_time;
+    double byte_rate = 0;
+    double frame_rate = 0;
+    std::string scratch;
+    AddressResolver resolver;
+    std::vector<AddressResolver::Result> resolved;
+
+    void apply_resolved();
+
+    // Подключение к уже разрешённому адресу не блокирует цикл
+    void connect_host(size_t index);
+
+    void finish_connect(size_t index);
+
+    void connected(size_t index);
+
+    // Закрывает соединение и назначает следующую попытку с удвоением паузы до 30 секунд
+    void drop(size_t index, std::string reason);
+
+    void subscribe(size_t index);
+
+    // Кадры агрегатора короткие и помещаются в буфер сокета; неполная отправка означает сломанное соединение
+    void send_frame(size_t index, const std::string& frame);
+
+    void receive(size_t index);
+
+    bool handle_frame(size_t index, char type, std::string_view payload);
+
+    void read_usage(Host& host, const Snapshot& snapshot);
+
+    // Самый горячий датчик; пороги max и crit идут без истории и не учитываются
+    void read_temperature(Host& host, const Snapshot& snapshot);
+
+    void build_overview();
+};
+
+// Форматирует числовое значение в единицах поля; вызывается только при отрисовке
+void format_number(double value, Unit unit, char* buf, size_t size);
+
+// Превращает снимок в строки для окна информации; буфер out переиспользуется между кадрами
+void format_snapshot(const Snapshot& snapshot, std::string& out);
+
+// Раздел истории под данными провайдера: по строке-спарклайну на каждую отслеживаемую метрику
+void append_history(std::string& out, HistoryStore& history, size_t provider, HistoryStore::Resolution resolution, int width);
+
+// Событие udev: сбросить кэш подсистемы и перечитать зависящие от неё провайдеры
+void on_device_change(const std::vector<std::unique_ptr<InfoProvider>>& providers, SamplingScheduler& scheduler,
+                      std::string_view subsystem);
+
+// Все провайдеры в порядке пунктов меню
+void make_providers(std::vector<std::unique_ptr<InfoProvider>>& providers, std::vector<std::string>& names,
+                    const InterfaceFilter& interfaces = {}, const std::string& root = "");
@@ -0,0 +1,114 @@
+// Дерево cgroup v2 на поддельной иерархии
+#include "check.h"
+
+namespace {
+
+void write_group(const FixtureRoot& root, const std::string& path, uint64_t usage_usec, uint64_t memory, uint64_t read_bytes,
+                 uint64_t write_bytes) {
+    const std::string dir = "sys/fs/cgroup/" + (path.empty() ? std::string() : path + "/");
+    root.write(dir + "cpu.stat", "usage_usec " + std::to_string(usage_usec) + "\nuser_usec 0\nsystem_usec 0\n");
+    root.write(dir + "io.stat", "8:0 rbytes=" + std::to_string(read_bytes) + " wbytes=" + std::to_string(write_bytes) +
+                                    " rios=1 wios=1\n259:0 rbytes=0 wbytes=0\n");
+    if (!path.empty()) {
+        root.write(dir + "memory.current", std::to_string(memory) + "\n");
+        root.write(dir + "memory.max", "max\n");
+        root.write(dir + "cpu.pressure", "some avg10=1.50 avg60=0.00 avg300=0.00 total=10\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    }
+}
+
+double row_number(const Snapshot& snapshot, std::string_view row, std::string_view name) {
+    const Field* field = find_row_field(snapshot, row, name);
+    return field && field->kind == FieldKind::Number ? field->value.number : -1.0;
+}
+
+void press(CgroupsProvider& provider, int key, int times) {
+    for (int i = 0; i < times; ++i) provider.handleKey(key);
+}
+
+} // namespace
+
+TEST(cgroups_tree_and_rates) {
+    FixtureRoot root;
+    root.write("sys/fs/cgroup/cgroup.controllers", "cpu io memory\n");
+    write_group(root, "", 0, 0, 0, 0);
+    write_group(root, "work", 1000000, 64 << 20, 0, 0);
+    write_group(root, "work/db", 500000, 32 << 20, 0, 0);
+    write_group(root, "work/db/shard", 100000, 16 << 20, 0, 0);
+
+    CgroupsProvider provider(root.path());
+    press(provider, 'c', 1); // глубина 3: видна вся иерархия
+    Snapshot out;
+    provider.sample(out);
+    const Field* groups = find_field(out, "Groups");
+    CHECK(groups && groups->value.number == 4);
+    // Первый опрос только задаёт точку отсчёта
+    CHECK(row_number(out, "  work", "CPU") == 0);
+    CHECK(row_number(out, "  work", "Memory") == 64 << 20);
+    CHECK(row_number(out, "/", "Memory") == 64 << 20);
+    CHECK(row_number(out, "  work", "CPU pressure") == 1.5);
+    const Field* limit = find_row_field(out, "  work", "Limit");
+    CHECK(limit && limit->kind == FieldKind::Text && out.text_of(*limit) == "max");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    write_group(root, "work", 1100000, 64 << 20, 1 << 20, 0);
+    write_group(root, "work/db/shard", 150000, 16 << 20, 0, 4096);
+    out.clear();
+    provider.sample(out);
+    CHECK(row_number(out, "  work", "CPU") > 0);
+    CHECK(row_number(out, "  work", "Read") > 0);
+    CHECK(row_number(out, "      shard", "Write") > 0);
+    CHECK(row_number(out, "    db", "CPU") == 0);
+
+    // Свёртываем до глубины 2: shard не читается, а его счётчики тем временем растут на часы работы
+    press(provider, 'c', 5);
+    out.clear();
+    provider.sample(out);
+    CHECK(find_row_field(out, "    db [+1]", "CPU"));
+    CHECK(!find_row_field(out, "      shard", "CPU"));
+    write_group(root, "work/db/shard", 150000 + 3600000000ull, 16 << 20, 1ull << 40, 1ull << 40);
+
+    // После раскрытия первый опрос shard — новая точка отсчёта, а не разность за всё время свёрнутости
+    press(provider, 'c', 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    out.clear();
+    provider.sample(out);
+    CHECK(row_number(out, "      shard", "CPU") == 0);
+    CHECK(row_number(out, "      shard", "Read") == 0);
+    CHECK(row_number(out, "      shard", "Write") == 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    write_group(root, "work/db/shard", 200000 + 3600000000ull, 16 << 20, (1ull << 40) + 8192, 1ull << 40);
+    out.clear();
+    provider.sample(out);
+    CHECK(row_number(out, "      shard", "CPU") > 0);
+    CHECK(row_number(out, "      shard", "Read") > 0);
+}
+
+TEST(cgroups_inotify_tracks_groups) {
+    FixtureRoot root;
+    root.write("sys/fs/cgroup/cgroup.controllers", "cpu io memory\n");
+    write_group(root, "", 0, 0, 0, 0);
+    write_group(root, "old", 0, 1 << 20, 0, 0);
+
+    CgroupsProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+    CHECK(find_row_field(out, "  old", "Memory"));
+
+    // Новые и удалённые каталоги подхватываются без полного обхода
+    write_group(root, "new", 0, 2 << 20, 0, 0);
+    std::filesystem::remove_all(root.path() + "/sys/fs/cgroup/old");
+    out.clear();
+    provider.sample(out);
+    CHECK(!find_row_field(out, "  old", "Memory"));
+    CHECK(row_number(out, "  new", "Memory") == 2 << 20);
+    const Field* groups = find_field(out, "Groups");
+    CHECK(groups && groups->value.number == 2);
+
+    // Исчезнувшая иерархия даёт сообщение об ошибке, а не чтение за границей
+    std::filesystem::remove_all(root.path() + "/sys/fs/cgroup");
+    provider.invalidate();
+    out.clear();
+    provider.sample(out);
+    CHECK(out.items().size() == 1 && out.items()[0].kind == FieldKind::Text);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// Минимальный набор для тестов без внешних зависимостей: TEST регистрирует функцию,
+// CHECK отмечает провал и продолжает выполнение, чтобы одним запуском увидеть все ошибки
+
+#include "sysinfo.h"
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+std::vector<TestCase>& test_registry();
+
+// Число проваленных проверок в текущем запуске
+extern int check_failures;
+
+#define TEST(name)                                                                                       \
+    static void name();                                                                                  \
+    static const bool name##_registered = (test_registry().push_back({#name, name}), true);              \
+    static void name()
+
+#define CHECK(condition)                                                                                 \
+    do {                                                                                                 \
+        if (!(condition)) {                                                                              \
+            ++check_failures;                                                                            \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                \
+        }                                                                                                \
+    } while (0)
+
+// Временное дерево каталогов вместо /proc и /sys; передаётся провайдерам как root
+class FixtureRoot {
+public:
+    FixtureRoot() {
+        char pattern[] = "/tmp/sysinfo_test_XXXXXX";
+        if (mkdtemp(pattern)) root = pattern;
+    }
+    FixtureRoot(const FixtureRoot&) = delete;
+    FixtureRoot& operator=(const FixtureRoot&) = delete;
+    ~FixtureRoot() {
+        std::error_code error;
+        if (!root.empty()) std::filesystem::remove_all(root, error);
+    }
+
+    const std::string& path() const { return root; }
+
+    // Создаёт файл вместе с недостающими каталогами; путь относительно корня
+    void write(const std::string& relative, std::string_view text) const {
+        std::filesystem::path file = root + "/" + relative;
+        std::filesystem::create_directories(file.parent_path());
+        std::ofstream(file, std::ios::binary | std::ios::trunc).write(text.data(), text.size());
+    }
+
+    void symlink(const std::string& target, const std::string& relative) const {
+        std::filesystem::path link = root + "/" + relative;
+        std::filesystem::create_directories(link.parent_path());
+        std::filesystem::create_symlink(target, link);
+    }
+
+private:
+    std::string root;
+};
+
+// Первое поле снимка с этим именем или nullptr
+inline const Field* find_field(const Snapshot& snapshot, std::string_view name) {
+    uint32_t id = metric_name(name);
+    for (const Field& field : snapshot.items()) {
+        if (field.name == id) return &field;
+    }
+    return nullptr;
+}
+
+// Поле, следующее за ключом строки таблицы (cpu3, card0, eth0)
+inline const Field* find_row_field(const Snapshot& snapshot, std::string_view row, std::string_view name) {
+    uint32_t id = metric_name(name);
+    bool in_row = false;
+    for (const Field& field : snapshot.items()) {
+        if (field.flags & kFieldRowKey) in_row = snapshot.text_of(field) == row;
+        else if (in_row && field.name == id) return &field;
+    }
+    return nullptr;
+}
+
+// Число открытых дескрипторов процесса
+inline size_t open_fds() {
+    size_t count = 0;
+    for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator("/proc/self/fd")) ++count;
+    return count;
+}
+
+inline bool near(double a, double b, double tolerance = 1e-6) { return std::fabs(a - b) <= tolerance; }
@@ -0,0 +1,144 @@
+// Запуск внешних команд: таймауты, большой вывод, ранний выход и утечки
+#include "check.h"
+
+#include <sys/prctl.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+// Осиротевшие потомки команд переходят к тесту, и их можно дождаться через waitpid
+void become_subreaper() { prctl(PR_SET_CHILD_SUBREAPER, 1, 0, 0, 0); }
+
+// Ни живых, ни зомби-потомков не осталось
+bool no_children() { return waitpid(-1, nullptr, WNOHANG) < 0 && errno == ECHILD; }
+
+std::vector<pid_t> parse_pids(std::string_view text) {
+    std::vector<pid_t> pids;
+    std::string_view line;
+    while (next_line(text, line)) {
+        pid_t pid = 0;
+        if (std::from_chars(line.data(), line.data() + line.size(), pid).ec == std::errc()) pids.push_back(pid);
+    }
+    return pids;
+}
+
+} // namespace
+
+TEST(command_timeout_kills_group) {
+    become_subreaper();
+    size_t fds = open_fds();
+    auto start = Clock::now();
+    CommandRunner runner;
+    // Оболочка и её фоновый sleep печатают свои pid и ждут дольше срока
+    size_t index = runner.start("echo $$; sleep 30 & echo $!; wait", 200);
+    runner.wait_all();
+    double elapsed = seconds_since(start);
+    const CommandResult& result = runner.result(index);
+
+    CHECK(result.timed_out);
+    CHECK(!result.failed);
+    CHECK(elapsed >= 0.2 && elapsed < 2.0);
+    // Вывод до таймаута сохраняется
+    std::vector<pid_t> pids = parse_pids(result.output);
+    CHECK(pids.size() == 2);
+    if (pids.size() == 2) {
+        // Оболочку runner уже дождался, поэтому её pid свободен
+        CHECK(kill(pids[0], 0) < 0 && errno == ESRCH);
+        // sleep из той же группы убит сигналом, а не оставлен работать
+        int status = 0;
+        CHECK(waitpid(pids[1], &status, 0) == pids[1]);
+        CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+    }
+    CHECK(no_children());
+    CHECK(open_fds() == fds);
+}
+
+TEST(command_large_output_truncated) {
+    size_t fds = open_fds();
+    CommandRunner runner;
+    size_t big = runner.start("head -c 3000000 /dev/zero; echo tail", 5000);
+    size_t small = runner.start("head -c 100000 /dev/zero", 5000);
+    runner.wait_all();
+
+    // Команда не ждёт освобождения канала и завершается сама
+    const CommandResult& result = runner.result(big);
+    CHECK(!result.timed_out);
+    CHECK(result.exit_status == 0);
+    CHECK(result.truncated);
+    CHECK(result.output.size() == CommandRunner::kMaxOutput);
+    CHECK(result.output.find_first_not_of('\0') == std::string::npos);
+
+    CHECK(!runner.result(small).truncated);
+    CHECK(runner.result(small).output.size() == 100000);
+    CHECK(no_children());
+    CHECK(open_fds() == fds);
+}
+
+TEST(command_exit_before_stdout_closes) {
+    become_subreaper();
+    size_t fds = open_fds();
+    auto start = Clock::now();
+    CommandRunner runner;
+    // Фоновая подоболочка держит канал открытым после выхода самой команды
+    size_t index = runner.start("echo out; (sleep 1; echo late) & exit 3", 5000);
+    runner.wait_all();
+    double elapsed = seconds_since(start);
+    const CommandResult& result = runner.result(index);
+
+    CHECK(!result.timed_out);
+    CHECK(result.exit_status == 3);
+    CHECK(result.output == "out\n");
+    CHECK(elapsed < 0.8);
+    CHECK(open_fds() == fds);
+
+    // Канал уже закрыт, поэтому поздняя запись подоболочки завершается SIGPIPE, а не блокируется
+    int status = 0;
+    pid_t orphan = waitpid(-1, &status, 0);
+    CHECK(orphan > 0 && WIFSIGNALED(status) && WTERMSIG(status) == SIGPIPE);
+    CHECK(no_children());
+}
+
+TEST(command_parallel_and_missing) {
+    size_t fds = open_fds();
+    auto start = Clock::now();
+    CommandRunner runner;
+    size_t first = runner.start("sleep 0.3; echo one", 3000);
+    size_t second = runner.start("sleep 0.3; echo two", 3000);
+    size_t third = runner.start("sleep 0.3; echo three 1>&2", 3000);
+    size_t missing = runner.start("/nonexistent/tool --version", 3000);
+    runner.wait_all();
+    double elapsed = seconds_since(start);
+
+    // Общее время — время самой медленной команды, а не сумма
+    CHECK(elapsed < 0.8);
+    CHECK(runner.result(first).output == "one\n");
+    CHECK(runner.result(second).output == "two\n");
+    CHECK(runner.result(third).output == "three\n");
+    CHECK(runner.result(missing).exit_status == 127);
+    CHECK(command_output(runner.result(first)) == "one\n");
+    CHECK(no_children());
+    CHECK(open_fds() == fds);
+}
+
+TEST(command_runner_destructor_kills) {
+    become_subreaper();
+    size_t fds = open_fds();
+    {
+        // wait_all не вызывается: разрушение runner убивает и дожидается процесс
+        CommandRunner runner;
+        runner.start("sleep 30 & wait", 60000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    // Оболочку дождался runner; её фоновый sleep убит вместе с группой и достаётся тесту
+    int status = 0;
+    int orphans = 0;
+    for (pid_t pid; (pid = waitpid(-1, &status, 0)) > 0; ++orphans) {
+        CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+    }
+    CHECK(orphans == 1);
+    CHECK(no_children());
+    CHECK(open_fds() == fds);
+}
@@ -0,0 +1,150 @@
+// Диски: /sys/block, /proc/diskstats и таблица монтирования на поддельном дереве
+#include "check.h"
+
+namespace {
+
+void write_block(const FixtureRoot& root, const std::string& name, const std::string& dev, const std::string& sectors) {
+    root.write("sys/block/" + name + "/dev", dev + "\n");
+    root.write("sys/block/" + name + "/size", sectors + "\n");
+}
+
+void write_partition(const FixtureRoot& root, const std::string& disk, const std::string& name, const std::string& dev) {
+    root.write("sys/block/" + disk + "/" + name + "/partition", "1\n");
+    root.write("sys/block/" + disk + "/" + name + "/dev", dev + "\n");
+}
+
+// Строка diskstats после "major minor name": reads merged sectors ms writes merged sectors ms in_flight io_ticks time_in_queue
+std::string diskstats_line(const char* device, uint64_t reads, uint64_t sectors_read, uint64_t read_ms,
+                           uint64_t writes, uint64_t sectors_written, uint64_t write_ms, uint64_t io_ms, uint64_t queue_ms) {
+    char line[256];
+    snprintf(line, sizeof(line), "%s %llu 0 %llu %llu %llu 0 %llu %llu 0 %llu %llu 0 0 0 0\n", device,
+             static_cast<unsigned long long>(reads), static_cast<unsigned long long>(sectors_read),
+             static_cast<unsigned long long>(read_ms), static_cast<unsigned long long>(writes),
+             static_cast<unsigned long long>(sectors_written), static_cast<unsigned long long>(write_ms),
+             static_cast<unsigned long long>(io_ms), static_cast<unsigned long long>(queue_ms));
+    return line;
+}
+
+double row_number(const Snapshot& snapshot, std::string_view row, std::string_view name) {
+    const Field* field = find_row_field(snapshot, row, name);
+    return field && field->kind == FieldKind::Number ? field->value.number : -1.0;
+}
+
+std::string row_text(const Snapshot& snapshot, std::string_view row, std::string_view name) {
+    const Field* field = find_row_field(snapshot, row, name);
+    return field && field->kind == FieldKind::Text ? std::string(snapshot.text_of(*field)) : std::string();
+}
+
+bool has_message(const Snapshot& snapshot, std::string_view text) {
+    for (const Field& field : snapshot.items()) {
+        if (field.kind == FieldKind::Text && field.name == 0 && !(field.flags & kFieldRowKey) && snapshot.text_of(field) == text) return true;
+    }
+    return false;
+}
+
+void write_fixture(const FixtureRoot& root) {
+    write_block(root, "sda", "8:0", "2000");
+    root.write("sys/block/sda/device/model", "Samsung SSD\n");
+    write_partition(root, "sda", "sda1", "8:1");
+    write_partition(root, "sda", "sda2", "8:2");
+    write_block(root, "dm-0", "253:0", "1000");
+    root.write("sys/block/dm-0/dm/name", "vg-root\n");
+    // loop и пустой кардридер не показываются
+    write_block(root, "loop0", "7:0", "100");
+    write_block(root, "sdb", "8:16", "0");
+
+    root.write("proc/self/mountinfo",
+               "22 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+               "23 22 0:21 / /proc rw,nosuid - proc proc rw\n"
+               "24 22 253:0 / /mnt/my\\040data rw,relatime - xfs /dev/mapper/vg-root rw\n"
+               "25 22 8:1 /home /home rw,relatime - ext4 /dev/sda1 rw\n"
+               "26 22 0:45 / /data rw,relatime - btrfs /dev/sdc2 rw\n");
+    root.write("mnt/my data/.keep", "");
+}
+
+} // namespace
+
+TEST(disks_devices_and_rates) {
+    FixtureRoot root;
+    write_fixture(root);
+    root.write("proc/diskstats", diskstats_line("8 0 sda", 100, 800, 50, 10, 80, 20, 40, 70) +
+                                     diskstats_line("8 1 sda1", 90, 700, 40, 5, 40, 10, 30, 50) +
+                                     diskstats_line("253 0 dm-0", 0, 0, 0, 0, 0, 0, 0, 0));
+
+    DisksProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+    CHECK(row_number(out, "sda", "Size") == 2000 * 512.0);
+    CHECK(row_number(out, "sda", "Partitions") == 2);
+    CHECK(row_text(out, "sda", "Model") == "Samsung SSD");
+    CHECK(row_number(out, "dm-0", "Size") == 1000 * 512.0);
+    CHECK(row_text(out, "dm-0", "Mapper") == "vg-root");
+    CHECK(!find_row_field(out, "loop0", "Size"));
+    CHECK(!find_row_field(out, "sdb", "Size"));
+    // Первый опрос только запоминает счётчики
+    CHECK(has_message(out, "Collecting statistics..."));
+    CHECK(!find_row_field(out, "sda", "Reads"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    root.write("proc/diskstats", diskstats_line("8 0 sda", 150, 1200, 150, 60, 480, 220, 60, 90) +
+                                     diskstats_line("8 1 sda1", 140, 1100, 140, 55, 440, 210, 50, 70) +
+                                     diskstats_line("253 0 dm-0", 0, 0, 0, 0, 0, 0, 0, 0));
+    out.clear();
+    provider.sample(out);
+    CHECK(!has_message(out, "Collecting statistics..."));
+    const double reads = row_number(out, "sda", "Reads");
+    const double writes = row_number(out, "sda", "Writes");
+    CHECK(reads > 0 && writes > 0 && near(reads, writes));
+    // Сектор diskstats — 512 байт; отношения не зависят от прошедшего времени
+    CHECK(near(row_number(out, "sda", "Read") / reads, 400 * 512.0 / 50, 1e-6));
+    CHECK(near(row_number(out, "sda", "Write") / writes, 400 * 512.0 / 50, 1e-6));
+    // Задержка — миллисекунды на операцию: (100 + 200) / (50 + 50)
+    CHECK(near(row_number(out, "sda", "Latency"), 3.0));
+    const double util = row_number(out, "sda", "Util");
+    CHECK(util >= 0 && util <= 100);
+    CHECK(row_number(out, "dm-0", "Reads") == 0);
+
+    // Новая строка diskstats означает новое устройство: состав перечитывается, скорости копятся заново
+    write_block(root, "nvme0n1", "259:0", "4000");
+    root.write("proc/diskstats", diskstats_line("8 0 sda", 150, 1200, 150, 60, 480, 220, 60, 90) +
+                                     diskstats_line("8 1 sda1", 140, 1100, 140, 55, 440, 210, 50, 70) +
+                                     diskstats_line("253 0 dm-0", 0, 0, 0, 0, 0, 0, 0, 0) +
+                                     diskstats_line("259 0 nvme0n1", 5, 40, 1, 0, 0, 0, 1, 1));
+    out.clear();
+    provider.sample(out);
+    out.clear();
+    provider.sample(out);
+    CHECK(row_number(out, "nvme0n1", "Size") == 4000 * 512.0);
+    CHECK(has_message(out, "Collecting statistics..."));
+}
+
+TEST(disks_mountinfo) {
+    FixtureRoot root;
+    write_fixture(root);
+    root.write("proc/diskstats", diskstats_line("8 0 sda", 0, 0, 0, 0, 0, 0, 0, 0));
+
+    DisksProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+    // Раздел подписан своим именем, \040 в пути — пробел; proc и bind-монтирование того же раздела пропущены
+    CHECK(row_text(out, "/", "Device") == "sda1");
+    CHECK(row_number(out, "/", "Size") >= 0);
+    CHECK(row_text(out, "/mnt/my data", "Device") == "dm-0");
+    CHECK(!find_row_field(out, "/proc", "Device"));
+    CHECK(!find_row_field(out, "/home", "Device"));
+    // btrfs с major 0 остаётся: источник в /dev; недоступная точка показывается как N/A
+    CHECK(row_text(out, "/data", "Device") == "sdc2");
+    CHECK(row_text(out, "/data", "Size") == "N/A");
+
+    // Без POLLPRI таблица не перечитывается; после сброса состава устройств — перечитывается
+    root.write("proc/self/mountinfo", "30 1 8:2 / /srv rw - ext4 /dev/sda2 rw\n");
+    out.clear();
+    provider.sample(out);
+    CHECK(find_row_field(out, "/", "Device"));
+    CHECK(!find_row_field(out, "/srv", "Device"));
+    provider.invalidate();
+    out.clear();
+    provider.sample(out);
+    CHECK(!find_row_field(out, "/", "Device"));
+    CHECK(row_text(out, "/srv", "Device") == "sda2");
+}
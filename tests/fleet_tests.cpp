@@ -0,0 +1,221 @@
+// Агент и агрегатор в одном процессе: два агента на unix-сокетах и агрегатор, который к ним подключается
+#include "check.h"
+
+namespace {
+
+const std::vector<std::string> kSections = {"System Usage", "Temperatures", "Processes"};
+enum { kUsage, kTemperatures, kProcesses };
+
+// Агент без провайдеров: снимки задаёт тест, сокет обслуживается так же, как в --agent
+class TestAgent {
+public:
+    TestAgent(const std::string& path, const std::string& host) : publisher(kSections, host), snapshots(kSections.size()) {
+        unlink(path.c_str());
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        sockaddr_storage storage;
+        socklen_t length;
+        if (parse_socket_address("unix:" + path, storage, length)) {
+            bind(listen_fd, reinterpret_cast<sockaddr*>(&storage), length);
+            listen(listen_fd, 8);
+        }
+    }
+    TestAgent(const TestAgent&) = delete;
+    TestAgent& operator=(const TestAgent&) = delete;
+    ~TestAgent() { close(listen_fd); }
+
+    void publish(size_t section, const Snapshot& snapshot) {
+        snapshots[section] = snapshot;
+        present[section] = true;
+        publisher.publish(section, snapshot);
+    }
+
+    void service() {
+        fds.assign(1, {listen_fd, POLLIN, 0});
+        publisher.add_pollfds(fds);
+        if (::poll(fds.data(), fds.size(), 0) <= 0) return;
+        std::vector<const Snapshot*> latest;
+        for (size_t i = 0; i < snapshots.size(); ++i) latest.push_back(present[i] ? &snapshots[i] : nullptr);
+        publisher.service(fds.data() + 1, latest, keys);
+        if (fds[0].revents) {
+            int fd;
+            while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0) publisher.add_peer(fd);
+        }
+    }
+
+    size_t peers() const { return publisher.peer_count(); }
+
+    std::vector<FleetPublisher::KeyRequest> keys;
+
+private:
+    int listen_fd = -1;
+    FleetPublisher publisher;
+    std::vector<Snapshot> snapshots;
+    bool present[3] = {};
+    std::vector<pollfd> fds;
+};
+
+Snapshot usage(double cpu, double memory) {
+    Snapshot snapshot;
+    snapshot.number(metric_name("CPU Usage"), cpu, Unit::Percent, kFieldHistory);
+    snapshot.number(metric_name("user"), cpu * 0.75, Unit::Percent, kFieldInline);
+    snapshot.separator();
+    snapshot.number(metric_name("Memory Usage"), memory, Unit::Percent, kFieldHistory);
+    return snapshot;
+}
+
+Snapshot temperatures(double package, double nvme) {
+    Snapshot snapshot;
+    snapshot.heading("coretemp");
+    snapshot.number(metric_name("Package id 0"), package, Unit::MilliCelsius, kFieldHistory);
+    snapshot.number(metric_name("Composite"), nvme, Unit::MilliCelsius, kFieldHistory);
+    return snapshot;
+}
+
+Snapshot processes(std::string_view sort, size_t rows) {
+    Snapshot snapshot;
+    snapshot.text(metric_name("Sort"), sort);
+    for (size_t i = 0; i < rows; ++i) {
+        snapshot.text(0, "pid" + std::to_string(1000 + i), kFieldRowKey, 8);
+        snapshot.number(metric_name("RSS"), 4096.0 * (i + 1), Unit::Bytes, kFieldInline);
+        snapshot.number(metric_name("CPU%"), 0.5 * i, Unit::Percent, kFieldInline);
+    }
+    return snapshot;
+}
+
+// Ячейка строки обзора: ключ строки — имя хоста с отметкой выбора "> " или "  "
+const Field* host_cell(const Snapshot& overview, std::string_view host, std::string_view name) {
+    const uint32_t id = metric_name(name);
+    bool in_row = false;
+    for (const Field& field : overview.items()) {
+        if (field.flags & kFieldRowKey) in_row = overview.text_of(field).substr(2) == host;
+        else if (in_row && field.name == id) return &field;
+    }
+    return nullptr;
+}
+
+bool host_number(const Snapshot& overview, std::string_view host, std::string_view name, double expected) {
+    const Field* field = host_cell(overview, host, name);
+    return field && field->kind == FieldKind::Number && near(field->value.number, expected);
+}
+
+std::string host_state(const Snapshot& overview, std::string_view host) {
+    const Field* field = host_cell(overview, host, "State");
+    return field ? std::string(overview.text_of(*field)) : std::string();
+}
+
+// Строки обзора сверху вниз
+std::vector<std::string> host_rows(const Snapshot& overview) {
+    std::vector<std::string> rows;
+    for (const Field& field : overview.items()) {
+        if (field.flags & kFieldRowKey) rows.emplace_back(overview.text_of(field));
+    }
+    return rows;
+}
+
+// Крутит агентов и агрегатор в одном потоке, пока не выполнится условие; обзор пересобирается по мере надобности
+template <typename Predicate>
+bool run_until(FleetAggregator& aggregator, std::initializer_list<TestAgent*> agents, Predicate done, int timeout_ms = 5000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (TestAgent* agent : agents) {
+            if (agent) agent->service();
+        }
+        aggregator.pump(5);
+        aggregator.poll(0);
+        if (done()) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(fleet_loopback) {
+    FixtureRoot root;
+    const std::string alpha_path = root.path() + "/alpha.sock";
+    const std::string beta_path = root.path() + "/beta.sock";
+    auto alpha = std::make_unique<TestAgent>(alpha_path, "alpha");
+    auto beta = std::make_unique<TestAgent>(beta_path, "beta");
+    // Снимки, готовые до подключения, приходят сразу после подписки
+    alpha->publish(kUsage, usage(25, 40));
+    alpha->publish(kTemperatures, temperatures(61000, 45000));
+    alpha->publish(kProcesses, processes("cpu", 50));
+    beta->publish(kUsage, usage(80, 20));
+    beta->publish(kTemperatures, temperatures(52000, 70000));
+    beta->publish(kProcesses, processes("memory", 3));
+
+    FleetAggregator aggregator({"unix:" + alpha_path, "unix:" + beta_path});
+    const Snapshot& overview = aggregator.latest(0);
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] {
+        return host_number(overview, "alpha", "CPU", 25) && host_number(overview, "beta", "CPU", 80);
+    }));
+    const Field* hosts = find_field(overview, "Hosts");
+    const Field* connected = find_field(overview, "Connected");
+    CHECK(hosts && hosts->value.number == 2);
+    CHECK(connected && connected->value.number == 2);
+    CHECK(host_number(overview, "alpha", "Memory", 40));
+    // Температура хоста — самый горячий датчик из истории
+    CHECK(host_number(overview, "alpha", "Temperature", 61000));
+    CHECK(host_number(overview, "beta", "Temperature", 70000));
+    CHECK(host_state(overview, "alpha") == "ok");
+    // Сортировка по CPU, выбран первый хост из списка
+    CHECK((host_rows(overview) == std::vector<std::string>{"  beta", "> alpha"}));
+
+    // Выбранный хост подписан на все разделы: его Processes пришёл целиком
+    CHECK(aggregator.selected_name() == "alpha");
+    CHECK(aggregator.host_sections() == kSections);
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] { return aggregator.has_sample(1 + kProcesses); }));
+    const Snapshot& alpha_processes = aggregator.latest(1 + kProcesses);
+    const Field* sort = find_field(alpha_processes, "Sort");
+    CHECK(sort && alpha_processes.text_of(*sort) == "cpu");
+    CHECK(alpha_processes.items().size() == 1 + 50 * 3);
+    const Field* rss = find_row_field(alpha_processes, "pid1049", "RSS");
+    CHECK(rss && rss->value.number == 4096.0 * 50);
+    const Field* cpu = find_row_field(alpha_processes, "pid1003", "CPU%");
+    CHECK(cpu && cpu->value.number == 1.5);
+
+    // Новые кадры обновляют обзор, дробные значения передаются без потерь
+    alpha->publish(kUsage, usage(91.25, 41));
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] { return host_number(overview, "alpha", "CPU", 91.25); }));
+    CHECK((host_rows(overview) == std::vector<std::string>{"> alpha", "  beta"}));
+
+    // Клавиша раздела уходит агенту выбранного хоста
+    aggregator.send_key(kProcesses, 's');
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] { return !alpha->keys.empty(); }));
+    CHECK(alpha->keys.size() == 1 && alpha->keys[0].section == kProcesses && alpha->keys[0].key == 's');
+    CHECK(beta->keys.empty());
+
+    // Невыбранный хост не присылает Processes, пока его не выберут
+    uint64_t layout = aggregator.layout_version();
+    aggregator.select_next(1);
+    CHECK(aggregator.selected_name() == "beta");
+    CHECK(aggregator.layout_version() != layout);
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] {
+        const Field* field = find_field(aggregator.latest(1 + kProcesses), "Sort");
+        return aggregator.has_sample(1 + kProcesses) && field && aggregator.latest(1 + kProcesses).text_of(*field) == "memory";
+    }));
+
+    // Перезапуск агента: соединение обрывается, агрегатор ждёт паузу и подключается заново
+    beta.reset();
+    CHECK(run_until(aggregator, {alpha.get()}, [&] { return host_state(overview, "beta").compare(0, 5, "retry") == 0; }));
+    const Field* reconnecting = find_field(overview, "Connected");
+    CHECK(reconnecting && reconnecting->value.number == 1);
+    beta = std::make_unique<TestAgent>(beta_path, "beta");
+    beta->publish(kUsage, usage(12, 30));
+    beta->publish(kTemperatures, temperatures(50000, 40000));
+    beta->publish(kProcesses, processes("pid", 2));
+    layout = aggregator.layout_version();
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] {
+        return host_number(overview, "beta", "CPU", 12) && host_state(overview, "beta") == "ok";
+    }));
+    // Новое приветствие выбранного хоста меняет раскладку меню, разделы приходят заново
+    CHECK(aggregator.layout_version() != layout);
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] {
+        const Field* field = find_field(aggregator.latest(1 + kProcesses), "Sort");
+        return field && aggregator.latest(1 + kProcesses).text_of(*field) == "pid";
+    }));
+    CHECK(beta->peers() == 1);
+    aggregator.send_key(kProcesses, 'r');
+    CHECK(run_until(aggregator, {alpha.get(), beta.get()}, [&] { return !beta->keys.empty(); }));
+    CHECK(beta->keys.size() == 1 && beta->keys[0].key == 'r');
+    CHECK(alpha->keys.size() == 1);
+}
@@ -0,0 +1,220 @@
+// Видеокарты: поддельное дерево DRM в sysfs и сценарий вместо nvidia-smi
+#include "check.h"
+
+namespace {
+
+// Поле из группы карты с данным адресом PCI; группы разделены разделителями и начинаются с заголовка-адреса
+const Field* gpu_field(const Snapshot& snapshot, std::string_view slot, std::string_view name) {
+    const uint32_t id = metric_name(name);
+    bool in_gpu = false;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind == FieldKind::Separator) in_gpu = false;
+        else if (field.kind == FieldKind::Heading) in_gpu = snapshot.text_of(field) == slot;
+        else if (in_gpu && field.name == id) return &field;
+    }
+    return nullptr;
+}
+
+bool gpu_number(const Snapshot& snapshot, std::string_view slot, std::string_view name, double expected) {
+    const Field* field = gpu_field(snapshot, slot, name);
+    return field && field->kind == FieldKind::Number && near(field->value.number, expected, 1e-3);
+}
+
+bool gpu_text(const Snapshot& snapshot, std::string_view slot, std::string_view name, std::string_view expected) {
+    const Field* field = gpu_field(snapshot, slot, name);
+    return field && field->kind == FieldKind::Text && snapshot.text_of(*field) == expected;
+}
+
+void write_pci_device(const FixtureRoot& root, const std::string& slot, const char* pci_class, const char* vendor,
+                      const char* device, const char* driver) {
+    const std::string dir = "sys/bus/pci/devices/" + slot + "/";
+    root.write(dir + "class", std::string(pci_class) + "\n");
+    root.write(dir + "vendor", std::string(vendor) + "\n");
+    root.write(dir + "device", std::string(device) + "\n");
+    root.write(dir + "uevent", std::string("DRIVER=") + driver + "\nPCI_SLOT_NAME=" + slot + "\n");
+}
+
+// Подменяет PATH на время теста, чтобы провайдер нашёл поддельную утилиту
+class ScopedPath {
+public:
+    explicit ScopedPath(const std::string& dir) {
+        const char* path = getenv("PATH");
+        saved = path ? path : "";
+        setenv("PATH", (dir + ":" + saved).c_str(), 1);
+    }
+    ~ScopedPath() { setenv("PATH", saved.c_str(), 1); }
+
+private:
+    std::string saved;
+};
+
+template <typename Predicate>
+bool sample_until(InfoProvider& provider, Snapshot& out, Predicate done) {
+    for (int attempt = 0; attempt < 300; ++attempt) {
+        out.clear();
+        provider.sample(out);
+        if (done(out)) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(gpu_sysfs_amdgpu_and_i915) {
+    FixtureRoot root;
+    const std::string amd = "0000:03:00.0";
+    const std::string intel = "0000:00:02.0";
+    write_pci_device(root, amd, "0x030000", "0x1002", "0x73bf", "amdgpu");
+    write_pci_device(root, intel, "0x030000", "0x8086", "0x9a49", "i915");
+    // Мост ISA не видеокарта и не показывается
+    write_pci_device(root, "0000:00:1f.0", "0x060100", "0x8086", "0xa082", "");
+
+    const std::string amd_dir = "sys/bus/pci/devices/" + amd + "/";
+    root.write(amd_dir + "gpu_busy_percent", "42\n");
+    root.write(amd_dir + "mem_info_vram_used", "1073741824\n");
+    root.write(amd_dir + "mem_info_vram_total", "17163091968\n");
+    root.write(amd_dir + "pp_dpm_sclk", "0: 500Mhz\n1: 2100Mhz *\n");
+    root.write(amd_dir + "pp_dpm_mclk", "0: 96Mhz *\n1: 1000Mhz\n");
+    root.write(amd_dir + "hwmon/hwmon3/temp1_input", "54000\n");
+    root.write(amd_dir + "hwmon/hwmon3/power1_average", "123000000\n");
+
+    // Каталог карты i915 и её разъёма; файлы частот лежат в /sys/class/drm/card0
+    const std::string intel_dir = "sys/bus/pci/devices/" + intel + "/";
+    root.write(intel_dir + "drm/card0-HDMI-A-1/status", "connected\n");
+    root.write(intel_dir + "drm/card0/dev", "226:0\n");
+    root.write("sys/class/drm/card0/gt_cur_freq_mhz", "1100\n");
+    root.write("sys/class/drm/card0/gt_max_freq_mhz", "1300\n");
+    root.write("sys/class/drm/card0/power/rc6_residency_ms", "1000\n");
+
+    GPUProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+
+    CHECK(gpu_text(out, amd, "Driver", "amdgpu"));
+    CHECK(gpu_number(out, amd, "GPU Utilization", 42));
+    CHECK(gpu_number(out, amd, "VRAM Used", 1073741824.0));
+    CHECK(gpu_number(out, amd, "VRAM Total", 17163091968.0));
+    CHECK(gpu_number(out, amd, "Shader Clock", 2100 * 1000.0));
+    CHECK(gpu_number(out, amd, "Memory Clock", 96 * 1000.0));
+    CHECK(gpu_number(out, amd, "Temperature", 54000));
+    CHECK(gpu_number(out, amd, "Power", 123000000));
+
+    CHECK(gpu_text(out, intel, "Driver", "i915"));
+    CHECK(gpu_number(out, intel, "Shader Clock", 1100 * 1000.0));
+    CHECK(gpu_number(out, intel, "Max Clock", 1300 * 1000.0));
+    // Для занятости по RC6 нужен второй отсчёт
+    CHECK(!gpu_field(out, intel, "GPU Utilization"));
+    CHECK(!gpu_field(out, "0000:00:1f.0", "Driver"));
+    // Адаптеры идут по адресу PCI
+    CHECK(!out.items().empty() && out.items()[0].kind == FieldKind::Heading && out.text_of(out.items()[0]) == intel);
+
+    // Значения перечитываются через уже открытые дескрипторы, новых не появляется
+    size_t fds = open_fds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    root.write(amd_dir + "gpu_busy_percent", "77\n");
+    root.write(amd_dir + "pp_dpm_sclk", "0: 500Mhz *\n1: 2100Mhz\n");
+    root.write("sys/class/drm/card0/gt_cur_freq_mhz", "350\n");
+    // RC6 не рос: карта всё время была занята
+    out.clear();
+    provider.sample(out);
+    CHECK(open_fds() == fds);
+    CHECK(gpu_number(out, amd, "GPU Utilization", 77));
+    CHECK(gpu_number(out, amd, "Shader Clock", 500 * 1000.0));
+    CHECK(gpu_number(out, intel, "Shader Clock", 350 * 1000.0));
+    CHECK(gpu_number(out, intel, "GPU Utilization", 100));
+
+    // RC6 вырос больше прошедшего времени: карта простаивала
+    root.write("sys/class/drm/card0/power/rc6_residency_ms", "100000\n");
+    out.clear();
+    provider.sample(out);
+    CHECK(gpu_number(out, intel, "GPU Utilization", 0));
+}
+
+TEST(gpu_command_stream_lines) {
+    size_t fds = open_fds();
+    CommandStream stream;
+    // Строка приходит двумя кусками, за ней пустая строка и выход
+    CHECK(stream.start("printf 'par'; sleep 0.2; printf 'tial\\n\\nnext\\n'; exit 0"));
+    std::vector<std::string> lines;
+    bool running = true;
+    for (int attempt = 0; attempt < 300 && running; ++attempt) {
+        running = stream.read_lines([&](std::string_view line) { lines.emplace_back(line); });
+        if (running) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(!running);
+    CHECK(!stream.running());
+    CHECK((lines == std::vector<std::string>{"partial", "", "next"}));
+
+    // Повторный запуск того же потока после выхода команды
+    lines.clear();
+    CHECK(stream.start("echo again; exec sleep 30"));
+    for (int attempt = 0; attempt < 300 && lines.empty(); ++attempt) {
+        CHECK(stream.read_lines([&](std::string_view line) { lines.emplace_back(line); }));
+        if (lines.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK((lines == std::vector<std::string>{"again"}));
+    stream.stop();
+    CHECK(!stream.running());
+    CHECK(waitpid(-1, nullptr, WNOHANG) < 0 && errno == ECHILD);
+    CHECK(open_fds() == fds);
+}
+
+TEST(gpu_nvidia_smi_stream) {
+    FixtureRoot root;
+    const std::string slot = "0000:01:00.0";
+    write_pci_device(root, slot, "0x030000", "0x10de", "0x2206", "nvidia");
+
+    // Первый запуск: строка с разрывом посередине, пустая строка, [N/A] и выход;
+    // второй запуск печатает новые значения и продолжает работать, как --loop-ms
+    root.write("bin/nvidia-smi",
+               "#!/bin/sh\n"
+               "dir=$(dirname \"$0\")\n"
+               "echo run >> \"$dir/runs\"\n"
+               "if [ \"$(wc -l < \"$dir/runs\")\" -eq 1 ]; then\n"
+               "  printf '0, 00000000:01:00.0, NVIDIA GeForce RTX 3080, 550'\n"
+               "  sleep 0.2\n"
+               "  printf '.54, 10240, 1234, 7, 45, 210, [N/A]\\n\\n'\n"
+               "  : > \"$dir/exited\"\n"
+               "  exit 0\n"
+               "fi\n"
+               "printf '0, 00000000:01:00.0, NVIDIA GeForce RTX 3080, 555.10, 10240, 4096, 93, 71, 1800, 250.50\\n'\n"
+               "exec sleep 30\n");
+    const std::string bin = root.path() + "/bin";
+    chmod((bin + "/nvidia-smi").c_str(), 0755);
+    ScopedPath path(bin);
+
+    GPUProvider provider(root.path());
+    Snapshot out;
+    CHECK(sample_until(provider, out, [&](const Snapshot& s) { return gpu_field(s, slot, "Driver Version"); }));
+    CHECK(gpu_text(out, slot, "Driver", "nvidia"));
+    CHECK(gpu_text(out, slot, "Driver Version", "550.54"));
+    CHECK(gpu_number(out, slot, "VRAM Total", 10240 * 1048576.0));
+    CHECK(gpu_number(out, slot, "VRAM Used", 1234 * 1048576.0));
+    CHECK(gpu_number(out, slot, "GPU Utilization", 7));
+    CHECK(gpu_number(out, slot, "Temperature", 45000));
+    CHECK(gpu_number(out, slot, "Shader Clock", 210 * 1000.0));
+    // [N/A] не превращается в ноль
+    CHECK(!gpu_field(out, slot, "Power"));
+
+    // После выхода nvidia-smi не перезапускается в каждом опросе
+    for (int attempt = 0; attempt < 300 && access((root.path() + "/bin/exited").c_str(), F_OK) != 0; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (int i = 0; i < 5; ++i) {
+        out.clear();
+        provider.sample(out);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(read_text_file(root.path() + "/bin/runs") == "run");
+    CHECK(gpu_text(out, slot, "Driver Version", "550.54"));
+
+    // Ручное обновление запускает его сразу
+    provider.invalidate();
+    CHECK(sample_until(provider, out, [&](const Snapshot& s) { return gpu_text(s, slot, "Driver Version", "555.10"); }));
+    CHECK(gpu_number(out, slot, "VRAM Used", 4096 * 1048576.0));
+    CHECK(gpu_number(out, slot, "GPU Utilization", 93));
+    CHECK(gpu_number(out, slot, "Temperature", 71000));
+    CHECK(gpu_number(out, slot, "Shader Clock", 1800 * 1000.0));
+    CHECK(gpu_number(out, slot, "Power", 250.5 * 1000000.0));
+}
@@ -0,0 +1,35 @@
+// Сеть: скорости счётчиков и дамп rtnetlink настоящего ядра
+#include "check.h"
+
+TEST(network_counter_reset) {
+    CHECK(counter_rate(1000, 3000, 2.0) == 1000);
+    CHECK(counter_rate(5000, 5000, 1.0) == 0);
+    // Сброс счётчика: отсчёт от нуля, а не разность через 2^64
+    CHECK(counter_rate(1ull << 40, 500, 0.5) == 1000);
+    CHECK(counter_rate(~0ull, 0, 1.0) == 0);
+    CHECK(counter_rate(0, 100, 0) == 0);
+}
+
+TEST(network_loopback_dump) {
+    size_t fds = open_fds();
+    {
+        NetworkProvider provider(InterfaceFilter{{"lo"}, {}});
+        Snapshot out;
+        provider.sample(out);
+        const Field* state = find_row_field(out, "lo", "State");
+        CHECK(state && state->kind == FieldKind::Text);
+        CHECK(!find_row_field(out, "lo", "RX"));
+
+        // Со второго дампа есть скорости; фильтр оставил только lo
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        out.clear();
+        provider.sample(out);
+        const Field* rx = find_row_field(out, "lo", "RX");
+        CHECK(rx && rx->unit == Unit::BytesPerSecond && rx->value.number >= 0 && rx->value.number < 1e12);
+        size_t rows = 0;
+        for (const Field& field : out.items()) rows += (field.flags & kFieldRowKey) != 0;
+        CHECK(rows == 1);
+    }
+    // Сокет rtnetlink закрывается вместе с провайдером
+    CHECK(open_fds() == fds);
+}
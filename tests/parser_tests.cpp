@@ -0,0 +1,168 @@
+// Разбор /proc и /sys и двоичная запись снимков
+#include "check.h"
+
+TEST(parser_cpu_list) {
+    CHECK((parse_cpu_list("0-3,8,10-11") == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    CHECK((parse_cpu_list("5") == std::vector<int>{5}));
+    CHECK(parse_cpu_list("").empty());
+    // Перевод строки в конце файла sysfs не ломает разбор
+    CHECK((parse_cpu_list("0-1\n") == std::vector<int>{0, 1}));
+}
+
+TEST(parser_u64_and_lines) {
+    std::string_view text = "MemTotal:  \t 16 kB\nlast";
+    std::string_view line;
+    CHECK(next_line(text, line) && line == "MemTotal:  \t 16 kB");
+    const char* p = line.data() + line.find(':') + 1;
+    uint64_t value = 0;
+    CHECK(parse_u64(p, line.data() + line.size(), value) && value == 16);
+    CHECK(!parse_u64(p, line.data() + line.size(), value));
+    CHECK(next_line(text, line) && line == "last");
+    CHECK(!next_line(text, line));
+}
+
+TEST(parser_format_number) {
+    char buf[32];
+    format_number(1536.0, Unit::Bytes, buf, sizeof(buf));
+    CHECK(std::string_view(buf) == "1.5 KiB");
+    format_number(512.0, Unit::BytesPerSecond, buf, sizeof(buf));
+    CHECK(std::string_view(buf) == "512 B/s");
+    format_number(45500.0, Unit::MilliCelsius, buf, sizeof(buf));
+    CHECK(std::string_view(buf) == "+45.5 C");
+    format_number(2500.0, Unit::Microseconds, buf, sizeof(buf));
+    CHECK(std::string_view(buf) == "2.50 ms");
+}
+
+TEST(parser_key_value_lines) {
+    Snapshot snapshot;
+    append_key_value_line(snapshot, "Manufacturer: ACME \r");
+    append_key_value_line(snapshot, "\tProduct Name:   Board");
+    append_key_value_line(snapshot, "Time: 12:30");
+    append_key_value_line(snapshot, "no colon here");
+    append_key_value_line(snapshot, "   ");
+    CHECK(snapshot.items().size() == 4);
+    const Field* manufacturer = find_field(snapshot, "Manufacturer");
+    CHECK(manufacturer && snapshot.text_of(*manufacturer) == "ACME");
+    const Field* product = find_field(snapshot, "Product Name");
+    CHECK(product && snapshot.text_of(*product) == "Board");
+    const Field* time = find_field(snapshot, "Time");
+    CHECK(time && snapshot.text_of(*time) == "12:30");
+    CHECK(snapshot.items().size() == 4 && snapshot.items()[3].name == 0);
+
+    Snapshot lines;
+    append_lines(lines, "first\nsecond");
+    CHECK(lines.items().size() == 2 && lines.text_of(lines.items()[1]) == "second");
+}
+
+TEST(parser_snapshot_roundtrip) {
+    Snapshot original;
+    original.heading("Disks");
+    original.text(metric_name("Model"), "Samsung SSD", kFieldRowKey, 12);
+    original.number(metric_name("Read"), 1234.5, Unit::BytesPerSecond, kFieldInline | kFieldHistory, 10);
+    original.separator();
+    original.message("Error: none");
+
+    std::string bytes;
+    serialize_snapshot(bytes, original);
+    std::string_view in = bytes;
+    Snapshot copy;
+    CHECK(deserialize_snapshot(in, copy));
+    CHECK(in.empty());
+    CHECK(copy.items().size() == original.items().size());
+    for (size_t i = 0; i < copy.items().size() && i < original.items().size(); ++i) {
+        const Field& a = original.items()[i];
+        const Field& b = copy.items()[i];
+        CHECK(a.name == b.name && a.kind == b.kind && a.unit == b.unit && a.flags == b.flags && a.width == b.width);
+        if (a.kind == FieldKind::Number) CHECK(a.value.number == b.value.number);
+        else if (a.kind != FieldKind::Separator) CHECK(original.text_of(a) == copy.text_of(b));
+    }
+
+    // Обрезанная запись отвергается, а не читается за границей
+    std::string_view truncated(bytes.data(), bytes.size() - 3);
+    Snapshot broken;
+    CHECK(!deserialize_snapshot(truncated, broken));
+}
+
+TEST(parser_meminfo_fixture) {
+    FixtureRoot root;
+    root.write("proc/meminfo",
+               "MemTotal:       16384 kB\n"
+               "MemFree:         1024 kB\n"
+               "MemAvailable:    8192 kB\n"
+               "HugePages_Total:      4\n"
+               "Hugepagesize:    2048 kB\n");
+    MeminfoReader reader(root.path());
+    CHECK(reader.update());
+    CHECK(reader.bytes(MeminfoReader::MemTotal) == 16384.0 * 1024);
+    CHECK(reader.bytes(MeminfoReader::MemAvailable) == 8192.0 * 1024);
+    CHECK(reader.count(MeminfoReader::HugePagesTotal) == 4);
+    CHECK(reader.bytes(MeminfoReader::SwapTotal) == 0);
+
+    // Файл перечитывается через тот же дескриптор
+    root.write("proc/meminfo", "MemTotal:       32768 kB\n");
+    CHECK(reader.update());
+    CHECK(reader.bytes(MeminfoReader::MemTotal) == 32768.0 * 1024);
+}
+
+TEST(parser_cpu_load_fixture) {
+    FixtureRoot root;
+    root.write("proc/stat",
+               "cpu  100 0 100 800 10 0 0 0 0 0\n"
+               "cpu0 50 0 50 400 0 0 0 0 0 0\n"
+               "cpu1 50 0 50 400 10 0 0 0 0 0\n"
+               "intr 12345\n");
+    CpuLoadEngine engine;
+    const std::string path = root.path() + "/proc/stat";
+    CHECK(engine.update(path));
+    CHECK(engine.rows() == 3);
+    CHECK(engine.cpu_id(0) == -1 && engine.cpu_id(2) == 1);
+
+    // cpu0 занят наполовину, nice входит в user; у cpu1 iowait уменьшился и не даёт минуса
+    root.write("proc/stat",
+               "cpu  150 10 120 920 5 0 0 0 0 0\n"
+               "cpu0 80 10 60 450 0 0 0 0 0 0\n"
+               "cpu1 70 0 60 470 5 0 0 0 0 0\n");
+    CHECK(engine.update(path));
+    CHECK(near(engine.share(CpuLoadEngine::ShareUser, 1), 40.0, 1e-3));
+    CHECK(near(engine.share(CpuLoadEngine::ShareBusy, 1), 50.0, 1e-3));
+    CHECK(near(engine.share(CpuLoadEngine::ShareBusy, 2), 30.0, 1e-3));
+    CHECK(near(engine.share(CpuLoadEngine::ShareIoWait, 2), 0.0));
+
+    // Отключение процессора меняет раскладку: разность берётся от нуля
+    root.write("proc/stat", "cpu  80 10 60 450 0 0 0 0 0 0\ncpu0 80 10 60 450 0 0 0 0 0 0\n");
+    CHECK(engine.update(path));
+    CHECK(engine.rows() == 2);
+    CHECK(near(engine.share(CpuLoadEngine::ShareBusy, 1), 25.0, 1e-3));
+}
+
+TEST(parser_inventory_cache_private) {
+    // Кэш создаётся при первом обращении и берёт каталог из окружения; другие тесты этого процесса его не трогают
+    FixtureRoot root;
+    setenv("XDG_CACHE_HOME", root.path().c_str(), 1);
+    unsetenv("SUDO_UID");
+    InventoryCache& cache = InventoryCache::instance();
+    Snapshot board;
+    board.text(metric_name("Serial Number"), "SN-0001");
+    cache.put("test.board", "dmi", board);
+
+    struct stat dir, file;
+    CHECK(stat((root.path() + "/sysinfo").c_str(), &dir) == 0 && (dir.st_mode & 0777) == 0700);
+    CHECK(stat((root.path() + "/sysinfo/inventory.bin").c_str(), &file) == 0 && (file.st_mode & 0777) == 0600);
+    Snapshot cached;
+    CHECK(cache.get("test.board", cached));
+    const Field* serial = find_field(cached, "Serial Number");
+    CHECK(serial && cached.text_of(*serial) == "SN-0001");
+
+    // Запись, собранная root, не выдаётся другому пользователю
+    if (getuid() == 0) {
+        pid_t child = fork();
+        if (child == 0) {
+            Snapshot out;
+            _exit(setuid(65534) == 0 && !cache.get("test.board", out) ? 0 : 1);
+        }
+        int status = 0;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    cache.invalidate("test.board");
+    unsetenv("XDG_CACHE_HOME");
+}
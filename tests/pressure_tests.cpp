@@ -0,0 +1,123 @@
+// Pressure: PSI, события vmstat, узлы NUMA и огромные страницы на поддельном дереве
+#include "check.h"
+
+namespace {
+
+std::string psi(double some10, uint64_t some_total, const char* full = nullptr) {
+    char text[256];
+    snprintf(text, sizeof(text), "some avg10=%.2f avg60=1.00 avg300=0.50 total=%llu\n%s", some10,
+             static_cast<unsigned long long>(some_total), full ? full : "");
+    return text;
+}
+
+std::string vmstat(uint64_t faults, uint64_t major, uint64_t stalls_normal, uint64_t stalls_movable, uint64_t oom) {
+    return "nr_free_pages 1000\npgfault " + std::to_string(faults) + "\npgmajfault " + std::to_string(major) +
+           "\npswpin 0\npswpout 0\ncompact_stall 3\nallocstall_dma32 0\nallocstall_normal " + std::to_string(stalls_normal) +
+           "\nallocstall_movable " + std::to_string(stalls_movable) + "\noom_kill " + std::to_string(oom) + "\n";
+}
+
+void write_node(const FixtureRoot& root, const std::string& node, uint64_t total_kb, uint64_t free_kb, uint64_t misses) {
+    const std::string dir = "sys/devices/system/node/" + node + "/";
+    const std::string id = node.substr(4);
+    root.write(dir + "meminfo", "Node " + id + " MemTotal:       " + std::to_string(total_kb) + " kB\nNode " + id +
+                                    " MemFree:        " + std::to_string(free_kb) + " kB\nNode " + id +
+                                    " FilePages:      2048 kB\nNode " + id + " AnonPages:      1024 kB\n");
+    root.write(dir + "numastat", "numa_hit 100\nnuma_miss " + std::to_string(misses) + "\nnuma_foreign 0\n");
+}
+
+double row_number(const Snapshot& snapshot, std::string_view row, std::string_view name) {
+    const Field* field = find_row_field(snapshot, row, name);
+    return field && field->kind == FieldKind::Number ? field->value.number : -1.0;
+}
+
+double number(const Snapshot& snapshot, std::string_view name) {
+    const Field* field = find_field(snapshot, name);
+    return field && field->kind == FieldKind::Number ? field->value.number : -1.0;
+}
+
+} // namespace
+
+TEST(pressure_psi_vmstat_and_nodes) {
+    FixtureRoot root;
+    // У cpu нет строки full на старых ядрах
+    root.write("proc/pressure/cpu", psi(2.5, 1000000));
+    root.write("proc/pressure/memory", psi(0.25, 500, "full avg10=0.10 avg60=0.00 avg300=0.00 total=200\n"));
+    root.write("proc/pressure/io", psi(7.0, 3000, "full avg10=3.00 avg60=0.00 avg300=0.00 total=100\n"));
+    root.write("proc/vmstat", vmstat(10000, 100, 1, 2, 0));
+    write_node(root, "node0", 8388608, 4194304, 10);
+    write_node(root, "node1", 8388608, 1048576, 0);
+    root.write("proc/meminfo",
+               "MemTotal:       16777216 kB\nMemFree:         5242880 kB\nSlab:             204800 kB\n"
+               "SReclaimable:     102400 kB\nSUnreclaim:       102400 kB\nKernelStack:       16384 kB\n"
+               "PageTables:        32768 kB\nAnonHugePages:    524288 kB\nShmemHugePages:         0 kB\n"
+               "HugePages_Total:      16\nHugePages_Free:        8\nHugePages_Rsvd:        2\n"
+               "HugePages_Surp:        0\nHugepagesize:       2048 kB\n");
+
+    PressureProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+    CHECK(row_number(out, "cpu some", "avg10") == 2.5);
+    CHECK(row_number(out, "cpu some", "avg60") == 1.0);
+    CHECK(row_number(out, "cpu some", "avg300") == 0.5);
+    CHECK(!find_row_field(out, "cpu full", "avg10"));
+    CHECK(row_number(out, "io full", "avg10") == 3.0);
+    // Прироста total ещё нет: текущая доля простоя — ноль
+    CHECK(row_number(out, "io some", "Stall") == 0);
+    CHECK(!find_field(out, "Page faults"));
+    CHECK(number(out, "OOM kills") == 0);
+
+    CHECK(row_number(out, "node0", "Total") == 8388608 * 1024.0);
+    CHECK(row_number(out, "node1", "Used") == (8388608 - 1048576) * 1024.0);
+    CHECK(row_number(out, "node0", "File") == 2048 * 1024.0);
+    CHECK(number(out, "Reserved") == 2);
+    CHECK(number(out, "Page Size") == 2048 * 1024.0);
+    CHECK(number(out, "Transparent (anon)") == 524288 * 1024.0);
+    CHECK(number(out, "Slab") == 204800 * 1024.0);
+    CHECK(number(out, "Page Tables") == 32768 * 1024.0);
+
+    // Второй опрос: скорости событий и доля простоя по приросту total
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    root.write("proc/pressure/io", psi(7.0, 3000 + 50000, "full avg10=3.00 avg60=0.00 avg300=0.00 total=100\n"));
+    root.write("proc/vmstat", vmstat(10000 + 4000, 100 + 40, 1 + 10, 2 + 30, 1));
+    write_node(root, "node0", 8388608, 4194304, 10 + 200);
+    out.clear();
+    provider.sample(out);
+    const double faults = number(out, "Page faults");
+    CHECK(faults > 0);
+    CHECK(near(number(out, "Major faults") / faults, 40.0 / 4000));
+    // allocstall_* по всем зонам складываются в одну скорость
+    CHECK(near(number(out, "Reclaim stalls") / faults, 40.0 / 4000));
+    CHECK(number(out, "Swap in") == 0);
+    CHECK(number(out, "OOM kills") == 1);
+    CHECK(near(row_number(out, "node0", "NUMA misses") / faults, 200.0 / 4000));
+    CHECK(row_number(out, "node1", "NUMA misses") == 0);
+    // 50 мс простоя за интервал около 0,1 с — примерно половина времени
+    const double stall = row_number(out, "io some", "Stall");
+    CHECK(stall > 0 && stall <= 50);
+    CHECK(row_number(out, "io full", "Stall") == 0);
+}
+
+TEST(pressure_counter_reset_and_missing_psi) {
+    FixtureRoot root;
+    root.write("proc/vmstat", vmstat(5000, 50, 0, 0, 0));
+    root.write("proc/meminfo", "MemTotal:       32768 kB\n");
+
+    PressureProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+    // Без /proc/pressure — сообщение вместо таблицы; без каталогов узлов нет раздела NUMA
+    bool psi_message = false;
+    for (const Field& field : out.items()) {
+        if (field.kind == FieldKind::Text && out.text_of(field).compare(0, 18, "PSI is unavailable") == 0) psi_message = true;
+    }
+    CHECK(psi_message);
+    CHECK(!find_row_field(out, "node0", "Total"));
+
+    // Счётчик меньше прошлого (сброс) не даёт огромной скорости
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    root.write("proc/vmstat", vmstat(10, 1, 0, 0, 0));
+    out.clear();
+    provider.sample(out);
+    CHECK(number(out, "Page faults") == 0);
+    CHECK(number(out, "Major faults") == 0);
+}
@@ -0,0 +1,196 @@
+// Запись сеанса и её воспроизведение: столбцы чисел, словарь текста, смена схемы и испорченные блоки
+#include "check.h"
+
+namespace {
+
+constexpr int64_t kStart = 1700000000000;
+
+const std::vector<std::string> kSections = {"System Usage", "Processes"};
+
+Snapshot usage(size_t tick) {
+    Snapshot snapshot;
+    snapshot.number(metric_name("CPU Usage"), 12.3 + tick % 7, Unit::Percent, kFieldHistory);
+    snapshot.number(metric_name("Memory"), 1048576.0 * (100 + tick), Unit::Bytes, kFieldInline);
+    snapshot.text(metric_name("Kernel"), "6.8.0");
+    return snapshot;
+}
+
+// Строки процессов меняются каждый опрос; с тика 100 в таблице на строку больше
+Snapshot processes(size_t tick) {
+    Snapshot snapshot;
+    snapshot.heading("Top processes");
+    const size_t rows = tick < 100 ? 3 : 4;
+    for (size_t row = 0; row < rows; ++row) {
+        snapshot.text(0, std::to_string(1000 + (tick + row) % 50), kFieldRowKey, 7);
+        snapshot.number(metric_name("CPU%"), 0.5 * row + tick % 3, Unit::Percent, kFieldInline | kFieldNoLabel, 8);
+        snapshot.text(metric_name("Command"), "worker-" + std::to_string(tick % 5), kFieldInline | kFieldNoLabel);
+    }
+    return snapshot;
+}
+
+std::string row_text(const Snapshot& snapshot, size_t row, std::string_view name) {
+    const uint32_t id = metric_name(name);
+    size_t seen = 0;
+    for (const Field& field : snapshot.items()) {
+        if (field.flags & kFieldRowKey) {
+            if (seen++ != row) continue;
+            if (name.empty()) return std::string(snapshot.text_of(field));
+        } else if (seen == row + 1 && field.name == id && field.kind == FieldKind::Text) {
+            return std::string(snapshot.text_of(field));
+        }
+    }
+    return std::string();
+}
+
+void record(const std::string& path, size_t ticks) {
+    SessionRecorder recorder;
+    CHECK(recorder.open(path, kSections));
+    for (size_t tick = 0; tick < ticks; ++tick) {
+        recorder.append(0, usage(tick), kStart + tick * 1000);
+        recorder.append(1, processes(tick), kStart + tick * 1000);
+    }
+    CHECK(recorder.ok());
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& data) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), data.size());
+}
+
+// Смещение первого блока после заголовка с именами разделов
+size_t data_start(std::string_view file) {
+    std::string_view in = file.substr(sizeof(record_format::kMagic) + sizeof(uint64_t));
+    uint32_t count = 0;
+    std::string_view name;
+    get_raw(in, count);
+    for (uint32_t i = 0; i < count && get_string(in, name);) ++i;
+    return file.size() - in.size();
+}
+
+// Обходит блоки файла записи: тип, смещение и данные
+template <typename Visit>
+void for_each_chunk(const std::string& file, Visit visit) {
+    for (size_t offset = data_start(file); offset + record_format::kChunkHeader <= file.size();) {
+        uint32_t size;
+        memcpy(&size, file.data() + offset + 1, sizeof(size));
+        visit(file[offset], offset, std::string_view(file).substr(offset + record_format::kChunkHeader, size));
+        offset += record_format::kChunkHeader + size;
+    }
+}
+
+} // namespace
+
+TEST(recording_roundtrip) {
+    FixtureRoot root;
+    const std::string path = root.path() + "/session.rec";
+    record(path, 150);
+
+    SessionReplay replay;
+    std::string error;
+    CHECK(replay.open(path, error));
+    CHECK(replay.section_names() == kSections);
+    CHECK(replay.begin() == kStart);
+    CHECK(replay.end() == kStart + 149 * 1000);
+
+    // Каждый отсчёт восстанавливается: числа с точностью записи, текст строк — из словаря блока
+    for (size_t tick : {0, 1, 63, 64, 65, 99, 100, 127, 128, 149}) {
+        replay.seek(kStart + tick * 1000);
+        CHECK(replay.poll(0));
+        CHECK(replay.poll(1));
+        const Snapshot& system = replay.latest(0);
+        const Field* cpu = find_field(system, "CPU Usage");
+        const Field* memory = find_field(system, "Memory");
+        const Field* kernel = find_field(system, "Kernel");
+        CHECK(cpu && near(cpu->value.number, 12.3 + tick % 7));
+        CHECK(memory && memory->value.number == 1048576.0 * (100 + tick));
+        CHECK(kernel && system.text_of(*kernel) == "6.8.0");
+
+        const Snapshot& table = replay.latest(1);
+        const Snapshot expected = processes(tick);
+        CHECK(table.items().size() == expected.items().size());
+        for (size_t row = 0; row < (tick < 100 ? 3u : 4u); ++row) {
+            CHECK(row_text(table, row, "") == row_text(expected, row, ""));
+            CHECK(row_text(table, row, "Command") == row_text(expected, row, "Command"));
+        }
+        const Field* row_cpu = find_row_field(table, std::to_string(1000 + (tick + 2) % 50), "CPU%");
+        CHECK(row_cpu && near(row_cpu->value.number, 1.0 + tick % 3));
+    }
+
+    // Тот же отсчёт повторно не отдаётся; до начала записи раздела нет
+    CHECK(!replay.poll(0));
+    replay.seek(kStart - 5000);
+    CHECK(replay.position() == kStart);
+}
+
+TEST(recording_text_is_not_a_schema_per_tick) {
+    FixtureRoot root;
+    const std::string path = root.path() + "/session.rec";
+    record(path, 99);
+
+    // Меняющийся текст строк хранится в блоках: схема раздела пишется один раз, пропусков нет
+    size_t schemas = 0, blocks = 0, dropped = 0;
+    for_each_chunk(read_file(path), [&](char type, size_t, std::string_view) {
+        schemas += type == 'S';
+        blocks += type == 'B';
+        dropped += type == 'D';
+    });
+    CHECK(schemas == kSections.size());
+    CHECK(blocks == 2 * kSections.size());
+    CHECK(dropped == 0);
+}
+
+TEST(recording_rejects_corrupt_blocks) {
+    FixtureRoot root;
+    const std::string path = root.path() + "/session.rec";
+    record(path, 1);
+    const std::string good = read_file(path);
+    uint64_t schema = 0;
+    for_each_chunk(good, [&](char type, size_t at, std::string_view data) {
+        uint64_t section;
+        if (type == 'S' && schema == 0 && get_varint(data, section) && section == 0) schema = at;
+    });
+    CHECK(schema != 0);
+
+    // Дописывает после индекса блок System Usage из n отсчётов: два числовых столбца с заданным
+    // заголовком и нулевыми данными, пустой словарь и столбец номеров текста схемы
+    auto with_block = [&](uint64_t n, uint8_t header) {
+        std::string block;
+        put_varint(block, 0);
+        put_varint(block, schema);
+        put_varint(block, n);
+        put_varint(block, zigzag(kStart + 10000));
+        for (uint64_t i = 1; i < n; ++i) put_varint(block, zigzag(1000));
+        for (int column = 0; column < 2; ++column) {
+            block += static_cast<char>(header);
+            put_varint(block, 0);
+            block.append(((n - ((header & 0x80) ? 1 : 0)) * (header & 0x7f) + 7) / 8, '\0');
+        }
+        put_varint(block, 0);
+        block += '\0';
+        put_varint(block, 0);
+        std::string data = good + 'B';
+        put_raw<uint32_t>(data, static_cast<uint32_t>(block.size()));
+        return data + block;
+    };
+    auto decodes = [&](const std::string& data) {
+        write_file(path, data);
+        SessionReplay replay;
+        std::string error;
+        if (!replay.open(path, error)) return false;
+        replay.seek(kStart + 10000);
+        return replay.poll(0) && replay.has_sample(0);
+    };
+
+    CHECK(decodes(with_block(record_format::kBlockTicks, 0)));
+    CHECK(decodes(with_block(record_format::kBlockTicks, 64)));
+    // Блок длиннее, чем делает писатель
+    CHECK(!decodes(with_block(record_format::kBlockTicks + 1, 0)));
+    CHECK(!decodes(with_block(100000, 0)));
+    // Ширина упаковки больше 64 бит
+    CHECK(!decodes(with_block(record_format::kBlockTicks, 65)));
+    CHECK(!decodes(with_block(record_format::kBlockTicks, 0x80 | 100)));
+}
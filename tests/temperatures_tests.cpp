@@ -0,0 +1,132 @@
+// Датчики hwmon и тепловые зоны на поддельном дереве sysfs
+#include "check.h"
+
+namespace {
+
+// Поле из группы с данным заголовком; группы разделены разделителями
+const Field* chip_field(const Snapshot& snapshot, std::string_view chip, std::string_view name) {
+    const uint32_t id = metric_name(name);
+    bool in_chip = false;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind == FieldKind::Separator) in_chip = false;
+        else if (field.kind == FieldKind::Heading) in_chip = snapshot.text_of(field) == chip;
+        else if (in_chip && field.name == id) return &field;
+    }
+    return nullptr;
+}
+
+bool reading(const Snapshot& snapshot, std::string_view chip, std::string_view name, double expected, Unit unit) {
+    const Field* field = chip_field(snapshot, chip, name);
+    return field && field->kind == FieldKind::Number && field->value.number == expected && field->unit == unit;
+}
+
+// Порог max или crit, продолжающий строку датчика
+double threshold(const Snapshot& snapshot, std::string_view chip, std::string_view sensor, std::string_view name) {
+    const std::vector<Field>& items = snapshot.items();
+    const Field* field = chip_field(snapshot, chip, sensor);
+    const uint32_t id = metric_name(name);
+    for (size_t i = field ? field - items.data() + 1 : items.size(); i < items.size() && (items[i].flags & kFieldInline); ++i) {
+        if (items[i].name == id) return items[i].value.number;
+    }
+    return -1;
+}
+
+// Заголовки групп в порядке вывода
+std::vector<std::string> chips(const Snapshot& snapshot) {
+    std::vector<std::string> names;
+    for (const Field& field : snapshot.items()) {
+        if (field.kind == FieldKind::Heading) names.emplace_back(snapshot.text_of(field));
+    }
+    return names;
+}
+
+void write_fixture(const FixtureRoot& root) {
+    const std::string core = "sys/class/hwmon/hwmon0/";
+    root.write(core + "name", "coretemp\n");
+    root.write(core + "temp1_input", "45000\n");
+    root.write(core + "temp1_label", "Package id 0\n");
+    root.write(core + "temp1_max", "80000\n");
+    root.write(core + "temp1_crit", "100000\n");
+    root.write(core + "temp2_input", "47000\n");
+    root.write(core + "temp2_label", "Core 0\n");
+    root.write(core + "temp2_max", "82000\n");
+    root.write(core + "temp2_crit", "101000\n");
+
+    // Без подписи датчик называется по каналу; файлы, кроме input, не становятся датчиками
+    const std::string nvme = "sys/class/hwmon/hwmon2/";
+    root.write(nvme + "name", "nvme\n");
+    root.write(nvme + "temp1_input", "38000\n");
+    root.write(nvme + "temp1_alarm", "0\n");
+
+    const std::string board = "sys/class/hwmon/hwmon10/";
+    root.write(board + "name", "nct6775\n");
+    root.write(board + "fan2_input", "1200\n");
+    root.write(board + "fan1_input", "900\n");
+    root.write(board + "fan1_label", "CPU Fan\n");
+    root.write(board + "fan1_min", "300\n");
+    root.write(board + "power1_average", "15000000\n");
+
+    const std::string zone = "sys/class/thermal/thermal_zone0/";
+    root.write(zone + "type", "acpitz\n");
+    root.write(zone + "temp", "50000\n");
+    root.write(zone + "trip_point_0_type", "critical\n");
+    root.write(zone + "trip_point_0_temp", "105000\n");
+    root.write(zone + "trip_point_1_type", "hot\n");
+    root.write(zone + "trip_point_1_temp", "95000\n");
+}
+
+} // namespace
+
+TEST(temperatures_hwmon_and_thermal_zones) {
+    FixtureRoot root;
+    write_fixture(root);
+    TemperaturesProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+
+    // Каталоги идут в естественном порядке: hwmon2 раньше hwmon10, тепловые зоны последними
+    CHECK((chips(out) == std::vector<std::string>{"coretemp (hwmon0)", "nvme (hwmon2)", "nct6775 (hwmon10)", "thermal (thermal_zone0)"}));
+
+    CHECK(reading(out, "coretemp (hwmon0)", "Package id 0", 45000, Unit::MilliCelsius));
+    CHECK(reading(out, "coretemp (hwmon0)", "Core 0", 47000, Unit::MilliCelsius));
+    CHECK(threshold(out, "coretemp (hwmon0)", "Package id 0", "max") == 80000);
+    CHECK(threshold(out, "coretemp (hwmon0)", "Package id 0", "crit") == 100000);
+    CHECK(threshold(out, "coretemp (hwmon0)", "Core 0", "max") == 82000);
+    CHECK(threshold(out, "coretemp (hwmon0)", "Core 0", "crit") == 101000);
+    const Field* package = chip_field(out, "coretemp (hwmon0)", "Package id 0");
+    CHECK(package && (package->flags & kFieldHistory));
+
+    CHECK(reading(out, "nvme (hwmon2)", "temp1", 38000, Unit::MilliCelsius));
+    CHECK(threshold(out, "nvme (hwmon2)", "temp1", "max") == -1);
+    CHECK(!chip_field(out, "nvme (hwmon2)", "temp1_alarm"));
+
+    CHECK(reading(out, "nct6775 (hwmon10)", "CPU Fan", 900, Unit::Rpm));
+    CHECK(reading(out, "nct6775 (hwmon10)", "fan2", 1200, Unit::Rpm));
+    CHECK(reading(out, "nct6775 (hwmon10)", "power1", 15000000, Unit::MicroWatts));
+
+    CHECK(reading(out, "thermal (thermal_zone0)", "acpitz", 50000, Unit::MilliCelsius));
+    CHECK(threshold(out, "thermal (thermal_zone0)", "acpitz", "max") == 95000);
+    CHECK(threshold(out, "thermal (thermal_zone0)", "acpitz", "crit") == 105000);
+
+    // Второй опрос перечитывает те же дескрипторы: новых не открывается, значения свежие
+    size_t fds = open_fds();
+    root.write("sys/class/hwmon/hwmon0/temp1_input", "61000\n");
+    root.write("sys/class/hwmon/hwmon10/fan1_input", "1500\n");
+    root.write("sys/class/thermal/thermal_zone0/temp", "52000\n");
+    out.clear();
+    provider.sample(out);
+    CHECK(open_fds() == fds);
+    CHECK(reading(out, "coretemp (hwmon0)", "Package id 0", 61000, Unit::MilliCelsius));
+    CHECK(reading(out, "nct6775 (hwmon10)", "CPU Fan", 1500, Unit::Rpm));
+    CHECK(reading(out, "thermal (thermal_zone0)", "acpitz", 52000, Unit::MilliCelsius));
+    CHECK(threshold(out, "coretemp (hwmon0)", "Package id 0", "crit") == 100000);
+}
+
+TEST(temperatures_no_sensors) {
+    FixtureRoot root;
+    TemperaturesProvider provider(root.path());
+    Snapshot out;
+    provider.sample(out);
+    CHECK(!out.empty() && out.items()[0].kind == FieldKind::Text && out.items()[0].name == 0);
+    CHECK(chips(out).empty());
+}
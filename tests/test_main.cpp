@@ -0,0 +1,26 @@
+// Запуск тестов: без аргументов — все, иначе только те, чьё имя начинается с аргумента
+#include "check.h"
+
+int check_failures = 0;
+
+std::vector<TestCase>& test_registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+int main(int argc, char** argv) {
+    std::string_view prefix = argc > 1 ? argv[1] : "";
+    int ran = 0;
+    int failed = 0;
+    for (const TestCase& test : test_registry()) {
+        if (std::string_view(test.name).compare(0, prefix.size(), prefix) != 0) continue;
+        int before = check_failures;
+        test.run();
+        ++ran;
+        bool ok = check_failures == before;
+        if (!ok) ++failed;
+        printf("%-48s %s\n", test.name, ok ? "ok" : "FAILED");
+    }
+    printf("%d tests, %d failed\n", ran, failed);
+    return ran == 0 || failed ? 1 : 0;
+}